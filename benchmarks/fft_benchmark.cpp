@@ -0,0 +1,356 @@
+// Speed and accuracy benchmark for the FFT engines, built and run on a host
+// by the top-level CMake project:
+//
+//   cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build --target fft_benchmark
+//   build/benchmarks/fft_benchmark [--json results.json] [--min-size 64] [--max-size 16384] [--min-time-ms 50]
+//
+// ctest runs it once over small sizes as a smoke test. The ArduinoFFT path used
+// by the real_time_fft component is measured too when configured with
+// -DARDUINOFFT_SRC=<the arduinoFFT library's src/ directory>.
+//
+// Every engine turns the same Hann-windowed test frame (three tones plus noise)
+// into N/2 magnitudes; stereo_pair transforms the frame as both channels of a
+// stereo pair, so its time covers two channels. Timing repeats the frame until
+// min-time has passed, five times, and keeps the fastest batch. Heap
+// allocations are counted through the global operator new while the timed loop
+// runs. Accuracy is the max and RMS magnitude error against a double-precision
+// DFT of the same windowed frame, relative to the largest and the RMS reference
+// magnitude, and Parseval is the relative difference between the spectrum
+// energy and the windowed time-domain energy (bins 0..N/2-1 only, so the
+// missing Nyquist bin shows up at ~1/N). Powers of two run from min-size to
+// max-size, followed by the sizes in that range that match 16/48 kHz sample
+// blocks, which use the mixed-radix and Bluestein transforms (and skip the
+// power-of-two-only engines). Results go to stderr as a table and, with
+// --json, to a file for regression checks. Every engine has error bounds, float
+// and Q31 tight, Q15 as loose as 16 bits need; the run exits non-zero when any
+// result exceeds them, Parseval counted beyond the reference DFT's own error.
+
+#include "reatimeFFT.h"
+#include "realtime_fft/fft_kernels.h"
+#include "realtime_fft/fft_plan.h"
+#include "realtime_fft/fixed_fft.h"
+#include "realtime_fft/multi_channel_fft.h"
+#include "realtime_fft/static_fft.h"
+
+#ifdef BENCH_ARDUINOFFT
+#include "arduinoFFT.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace esphome::realtime_fft;
+
+static std::atomic<uint64_t> g_allocations{0};
+
+// Counting replacements for the global allocator, kept out of line so GCC
+// doesn't flag the inlined malloc/free pairs as mismatched new/delete
+__attribute__((noinline)) void *operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size > 0 ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+__attribute__((noinline)) void *operator new[](size_t size) { return operator new(size); }
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Result {
+  std::string engine;
+  size_t size;
+  double ns_per_frame;
+  double allocations_per_frame;
+  double max_error;
+  double rms_error;
+  double parseval_error;
+  // Parseval error beyond the reference DFT's own
+  double parseval_excess;
+};
+
+// Largest accepted errors, relative as in Result
+struct ErrorBounds {
+  double max_error;
+  double rms_error;
+  double parseval_excess;
+};
+
+const ErrorBounds FLOAT_BOUNDS{1e-5, 1e-5, 1e-5};
+// 31-bit data, scaled down by one bit per stage
+const ErrorBounds Q31_BOUNDS{1e-4, 1e-4, 1e-4};
+// 16-bit data: the RMS error grows with sqrt(N) and reaches ~1e-2 at 16384
+const ErrorBounds Q15_BOUNDS{5e-3, 2e-2, 1e-3};
+
+// One engine prepared for one size: turns the shared frame into size/2 magnitudes
+struct Engine {
+  std::string name;
+  std::function<void(float *magnitudes)> run;
+  ErrorBounds bounds = FLOAT_BOUNDS;
+};
+
+std::vector<float> make_frame(size_t n) {
+  std::mt19937 rng(12345);
+  std::normal_distribution<float> noise(0.0f, 0.01f);
+  std::vector<float> frame(n);
+  for (size_t i = 0; i < n; i++) {
+    const double t = static_cast<double>(i) / n;
+    frame[i] = static_cast<float>(0.5 * std::sin(2 * M_PI * 7.3 * t) + 0.25 * std::sin(2 * M_PI * (n / 5.0 + 0.4) * t) +
+                                  0.1 * std::cos(2 * M_PI * (n / 2.7) * t)) +
+               noise(rng);
+  }
+  return frame;
+}
+
+// Magnitudes of the DFT of the Hann-windowed frame, in double precision
+std::vector<double> reference_magnitudes(const std::vector<float> &frame, double *time_energy) {
+  const size_t n = frame.size();
+  std::vector<double> x(n), cos_table(n), sin_table(n);
+  *time_energy = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    x[i] = frame[i] * 0.5 * (1.0 - std::cos(2.0 * M_PI * i / (n - 1)));
+    *time_energy += x[i] * x[i];
+    cos_table[i] = std::cos(2.0 * M_PI * i / n);
+    sin_table[i] = std::sin(2.0 * M_PI * i / n);
+  }
+  std::vector<double> mags(n / 2);
+  for (size_t k = 0; k < n / 2; k++) {
+    double re = 0.0, im = 0.0;
+    size_t idx = 0;
+    for (size_t i = 0; i < n; i++) {
+      re += x[i] * cos_table[idx];
+      im -= x[i] * sin_table[idx];
+      idx += k;
+      if (idx >= n)
+        idx -= n;
+    }
+    mags[k] = std::sqrt(re * re + im * im);
+  }
+  return mags;
+}
+
+template<size_t N> std::shared_ptr<StaticFFTBase> make_static(size_t n) {
+  if constexpr (N > 4096) {
+    return nullptr;
+  } else {
+    if (n == N)
+      return std::make_shared<StaticFFT<N>>();
+    return make_static<N * 2>(n);
+  }
+}
+
+std::vector<Engine> make_engines(const std::vector<float> &frame) {
+  const size_t n = frame.size();
+  std::vector<Engine> engines;
+
+  auto scalar = std::make_shared<FFTPlan>(n);
+  scalar->set_kernel(radix4_scalar_kernel());
+  auto plan = std::make_shared<FFTPlan>(n);
+  auto re = std::make_shared<std::vector<float>>(n / 2 + 1);
+  auto im = std::make_shared<std::vector<float>>(n / 2 + 1);
+  auto plan_engine = [&frame, n, re, im](std::shared_ptr<FFTPlan> p) {
+    return [&frame, n, re, im, p](float *out) {
+      p->forward_real(frame.data(), re->data(), im->data(), true);
+      for (size_t k = 0; k < n / 2; k++)
+        out[k] = std::sqrt((*re)[k] * (*re)[k] + (*im)[k] * (*im)[k]);
+    };
+  };
+  engines.push_back({std::string("plan_") + scalar->kernel_name(), plan_engine(scalar)});
+  if (std::strcmp(plan->kernel_name(), scalar->kernel_name()) != 0)
+    engines.push_back({std::string("plan_") + plan->kernel_name(), plan_engine(plan)});
+
+  if (auto fft = make_static<8>(n))
+    engines.push_back({"static", [&frame, fft](float *out) { fft->magnitudes(frame.data(), out); }});
+
+  auto stereo = std::make_shared<MultiChannelFFT>(n, 2);
+  auto stereo_in = std::make_shared<std::vector<float>>(frame);
+  stereo_in->insert(stereo_in->end(), frame.begin(), frame.end());
+  auto stereo_out = std::make_shared<std::vector<float>>(n);
+  engines.push_back({"stereo_pair", [n, stereo, stereo_in, stereo_out](float *out) {
+                       stereo->magnitudes(stereo_in->data(), stereo_out->data());
+                       std::copy_n(stereo_out->begin(), n / 2, out);
+                     }});
+
+  auto q15_in = std::make_shared<std::vector<int16_t>>(n);
+  auto q31_in = std::make_shared<std::vector<int32_t>>(n);
+  for (size_t i = 0; i < n; i++) {
+    const float x = std::max(-1.0f, std::min(frame[i], 0.999f));
+    (*q15_in)[i] = static_cast<int16_t>(std::lround(x * 32768.0f));
+    (*q31_in)[i] = static_cast<int32_t>(std::llround(x * 2147483648.0));
+  }
+  auto q15 = std::make_shared<FixedFFT<int16_t>>(n);
+  auto q31 = std::make_shared<FixedFFT<int32_t>>(n);
+  if (q15->is_valid())
+    engines.push_back({"q15", [q15, q15_in](float *out) { q15->magnitudes(q15_in->data(), out); }, Q15_BOUNDS});
+  if (q31->is_valid())
+    engines.push_back({"q31", [q31, q31_in](float *out) { q31->magnitudes(q31_in->data(), out); }, Q31_BOUNDS});
+
+  auto standalone = std::make_shared<RealtimeFFT>(static_cast<int>(n));
+  engines.push_back({"realtime_fft", [&frame, n, standalone](float *out) {
+                       standalone->process(frame.data(), n);
+                       standalone->getMagnitudeSpectrum(out, n / 2);
+                     }});
+
+#ifdef BENCH_ARDUINOFFT
+  auto a_re = std::make_shared<std::vector<float>>(n);
+  auto a_im = std::make_shared<std::vector<float>>(n);
+  auto arduino = std::make_shared<ArduinoFFT<float>>(a_re->data(), a_im->data(), n, 44100.0f);
+  engines.push_back({"arduinofft", [&frame, n, a_re, a_im, arduino](float *out) {
+                       std::copy(frame.begin(), frame.end(), a_re->begin());
+                       std::fill(a_im->begin(), a_im->end(), 0.0f);
+                       arduino->windowing(FFT_WIN_TYP_HANNING, FFT_FORWARD);
+                       arduino->compute(FFT_FORWARD);
+                       arduino->complexToMagnitude();
+                       std::copy_n(a_re->begin(), n / 2, out);
+                     }});
+#endif
+
+  return engines;
+}
+
+Result measure(const Engine &engine, const std::vector<double> &reference, double time_energy, size_t n,
+               double min_time_ms) {
+  using Clock = std::chrono::steady_clock;
+  std::vector<float> out(n / 2);
+  Result result{engine.name, n, 0, 0, 0, 0, 0, 0};
+
+  // Warm up caches and lazily built tables, then find a batch length
+  engine.run(out.data());
+  size_t frames = 1;
+  for (;;) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < frames; i++)
+      engine.run(out.data());
+    if (std::chrono::duration<double, std::milli>(Clock::now() - start).count() >= min_time_ms)
+      break;
+    frames *= 2;
+  }
+
+  double best = 1e300;
+  uint64_t allocations = 0;
+  for (int batch = 0; batch < 5; batch++) {
+    const uint64_t before = g_allocations.load();
+    auto start = Clock::now();
+    for (size_t i = 0; i < frames; i++)
+      engine.run(out.data());
+    const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    allocations += g_allocations.load() - before;
+    best = std::min(best, ns / frames);
+  }
+  result.ns_per_frame = best;
+  result.allocations_per_frame = static_cast<double>(allocations) / (5.0 * frames);
+
+  double peak = 0.0, ref_square = 0.0, max_error = 0.0, error_square = 0.0, energy = 0.0, ref_energy = 0.0;
+  for (size_t k = 0; k < n / 2; k++) {
+    const double error = std::fabs(out[k] - reference[k]);
+    peak = std::max(peak, reference[k]);
+    ref_square += reference[k] * reference[k];
+    max_error = std::max(max_error, error);
+    error_square += error * error;
+    energy += (k == 0 ? 1.0 : 2.0) * out[k] * out[k];
+    ref_energy += (k == 0 ? 1.0 : 2.0) * reference[k] * reference[k];
+  }
+  result.max_error = max_error / peak;
+  result.rms_error = std::sqrt(error_square / ref_square);
+  result.parseval_error = std::fabs(energy / n - time_energy) / time_energy;
+  result.parseval_excess = std::fabs(energy - ref_energy) / n / time_energy;
+  return result;
+}
+
+void write_json(const char *path, const std::vector<Result> &results) {
+  FILE *f = std::fopen(path, "w");
+  if (f == nullptr) {
+    std::fprintf(stderr, "cannot write %s\n", path);
+    return;
+  }
+  std::fprintf(f, "{\n  \"results\": [\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &r = results[i];
+    std::fprintf(f,
+                 "    {\"engine\": \"%s\", \"size\": %zu, \"ns_per_frame\": %.1f, \"ns_per_sample\": %.3f, "
+                 "\"frames_per_second\": %.1f, \"allocations_per_frame\": %.3f, \"max_error\": %.3e, "
+                 "\"rms_error\": %.3e, \"parseval_error\": %.3e}%s\n",
+                 r.engine.c_str(), r.size, r.ns_per_frame, r.ns_per_frame / r.size, 1e9 / r.ns_per_frame,
+                 r.allocations_per_frame, r.max_error, r.rms_error, r.parseval_error,
+                 i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(f, "  ]\n}\n");
+  std::fclose(f);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const char *json_path = nullptr;
+  size_t min_size = 64, max_size = 16384;
+  double min_time_ms = 50.0;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--json") == 0) {
+      json_path = argv[i + 1];
+    } else if (std::strcmp(argv[i], "--min-size") == 0) {
+      min_size = std::strtoul(argv[i + 1], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--max-size") == 0) {
+      max_size = std::strtoul(argv[i + 1], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--min-time-ms") == 0) {
+      min_time_ms = std::strtod(argv[i + 1], nullptr);
+    } else {
+      std::fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  std::vector<size_t> sizes;
+  for (size_t n = min_size; n <= max_size; n *= 2)
+    sizes.push_back(n);
+  // 10/20/30/60 ms at 16 and 48 kHz; 998 = 2 * 499 exercises Bluestein
+  for (size_t n : {160, 320, 480, 960, 998, 1000, 1440, 1920, 2880}) {
+    if (n >= min_size && n <= max_size)
+      sizes.push_back(n);
+  }
+
+  std::vector<Result> results;
+  int failures = 0;
+  std::fprintf(stderr, "%-16s %6s %12s %9s %10s %7s %10s %10s %10s\n", "engine", "size", "ns/frame", "ns/sample",
+               "frames/s", "allocs", "max_err", "rms_err", "parseval");
+  for (size_t n : sizes) {
+    const std::vector<float> frame = make_frame(n);
+    double time_energy;
+    const std::vector<double> reference = reference_magnitudes(frame, &time_energy);
+    for (const Engine &engine : make_engines(frame)) {
+      const Result r = measure(engine, reference, time_energy, n, min_time_ms);
+      std::fprintf(stderr, "%-16s %6zu %12.1f %9.3f %10.1f %7.2f %10.2e %10.2e %10.2e\n", r.engine.c_str(), r.size,
+                   r.ns_per_frame, r.ns_per_frame / r.size, 1e9 / r.ns_per_frame, r.allocations_per_frame,
+                   r.max_error, r.rms_error, r.parseval_error);
+      const ErrorBounds &b = engine.bounds;
+      if (r.max_error > b.max_error || r.rms_error > b.rms_error || r.parseval_excess > b.parseval_excess) {
+        std::fprintf(stderr, "FAIL %s %zu: max %.2e, rms %.2e, Parseval excess %.2e over bounds %.0e/%.0e/%.0e\n",
+                     r.engine.c_str(), r.size, r.max_error, r.rms_error, r.parseval_excess, b.max_error, b.rms_error,
+                     b.parseval_excess);
+        failures++;
+      }
+      results.push_back(r);
+    }
+  }
+
+  if (json_path != nullptr)
+    write_json(json_path, results);
+  if (failures != 0) {
+    std::fprintf(stderr, "%d results out of bounds\n", failures);
+    return 1;
+  }
+  return 0;
+}
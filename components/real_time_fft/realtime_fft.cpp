@@ -19,8 +19,8 @@ void RealtimeFFTComponent::setup() {
   }
   
   // Allouer la mémoire pour les tableaux FFT
-  this->real_values_ = new double[this->fft_size_];
-  this->imag_values_ = new double[this->fft_size_];
+  this->real_values_ = new float[this->fft_size_];
+  this->imag_values_ = new float[this->fft_size_];
   this->spectrum_data_ = new float[this->fft_size_ / 2];
   
   // Allouer le buffer audio
@@ -28,7 +28,7 @@ void RealtimeFFTComponent::setup() {
   this->audio_buffer_ = new int16_t[this->fft_size_];
   
   // Initialiser l'objet FFT
-  this->fft_ = new ArduinoFFT<double>(this->real_values_, this->imag_values_, this->fft_size_, this->sample_rate_);
+  this->fft_ = new ArduinoFFT<float>(this->real_values_, this->imag_values_, this->fft_size_, this->sample_rate_);
   
   // Calculer les fréquences correspondantes
   this->frequency_bins_ = new float[this->fft_size_ / 2];
@@ -34,13 +34,13 @@ class RealtimeFFTComponent : public Component, public sensor::Sensor {
   size_t buffer_size_{0};
   
   // Tableaux pour le calcul FFT
-  double *real_values_{nullptr};
-  double *imag_values_{nullptr};
+  float *real_values_{nullptr};
+  float *imag_values_{nullptr};
   float *spectrum_data_{nullptr};
   float *frequency_bins_{nullptr};
   
   // Objet FFT
-  ArduinoFFT<double> *fft_{nullptr};
+  ArduinoFFT<float> *fft_{nullptr};
 };
 
 }  // namespace realtime_fft
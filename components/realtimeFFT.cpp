@@ -1,102 +1,215 @@
-#include "realtimeFFT.h"
+#include "reatimeFFT.h"
 #include <algorithm>
 #include <numeric>
+#include <stdexcept>
+#include <utility>
 
-RealtimeFFT::RealtimeFFT(int fftSize) : 
-    m_fftSize(fftSize),
-    m_complexBuffer(fftSize),
-    m_magnitudeSpectrum(fftSize / 2),
+int RealtimeFFT::validatedFftSize(int fftSize, int hopSize, int channels, float sampleRate) {
+    if (channels < 1) {
+        throw std::invalid_argument("At least one channel is required");
+    }
+    if (fftSize < 1 || !esphome::realtime_fft::FFTPlan::is_supported_size(static_cast<size_t>(fftSize))) {
+        throw std::invalid_argument("FFT size must be even and at most 65536");
+    }
+    if (!(sampleRate > 0.0f)) {
+        throw std::invalid_argument("Sample rate must be positive");
+    }
+    if (hopSize > fftSize) {
+        throw std::invalid_argument("Hop size must not exceed FFT size");
+    }
+    return fftSize;
+}
+
+RealtimeFFT::RealtimeFFT(int fftSize, int hopSize, int channels, float sampleRate) : 
+    m_fftSize(validatedFftSize(fftSize, hopSize, channels, sampleRate)),
+    m_channels(channels),
+    m_sampleRate(sampleRate),
+    m_fft(fftSize, channels),
+    m_framer(fftSize, hopSize > 0 ? hopSize : fftSize, channels),
+    m_magnitudeSpectrum(static_cast<size_t>(channels) * (fftSize / 2)),
     m_frequencyBins(fftSize / 2) {
-    
+
     // Pre-compute frequency bins
     for (int k = 0; k < m_fftSize / 2; ++k) {
-        m_frequencyBins[k] = k * (44100.0 / m_fftSize);
+        m_frequencyBins[k] = k * (m_sampleRate / m_fftSize);
     }
 }
 
 void RealtimeFFT::processAudioData(const std::vector<float>& audioInput) {
+    process(audioInput.data(), audioInput.size());
+}
+
+void RealtimeFFT::process(const float* samples, size_t count) {
     // Ensure input matches FFT size
-    if (audioInput.size() != m_fftSize) {
+    if (count != static_cast<size_t>(m_fftSize) * m_channels) {
         throw std::runtime_error("Input size does not match FFT size");
     }
 
-    // Convert input to complex numbers
-    for (int i = 0; i < m_fftSize; ++i) {
-        m_complexBuffer[i] = std::complex<float>(audioInput[i], 0.0f);
+    if (m_channels == 1) {
+        processFrame(samples);
+        return;
     }
+    m_frame.resize(count);
+    esphome::realtime_fft::deinterleave(samples, m_fftSize, m_channels, m_frame.data(), m_fftSize);
+    processFrame(m_frame.data());
+}
 
-    // Apply Hann window
-    for (int i = 0; i < m_fftSize; ++i) {
-        float window = 0.5f * (1.0f - std::cos(2.0f * M_PI * i / (m_fftSize - 1)));
-        m_complexBuffer[i] *= window;
+size_t RealtimeFFT::pushAudioData(const float* samples, size_t count) {
+    if (m_sliding) {
+        pushSliding(samples, count);
+        return 0;
     }
+    return m_framer.push(samples, count, [this](const float* frame) {
+        processFrame(frame);
+        if (m_frameCallback) {
+            m_frameCallback(*this);
+        }
+    });
+}
 
-    // Perform FFT
-    cooleyTukeyFFT(m_complexBuffer);
+void RealtimeFFT::setFrameCallback(FrameCallback callback) {
+    m_frameCallback = std::move(callback);
+}
 
-    // Compute magnitude spectrum (first half)
-    for (int k = 0; k < m_fftSize / 2; ++k) {
-        m_magnitudeSpectrum[k] = std::abs(m_complexBuffer[k]);
+void RealtimeFFT::resetStream() {
+    m_framer.reset();
+    if (m_sliding) {
+        m_sliding->reset();
+        std::fill(m_triggered.begin(), m_triggered.end(), false);
     }
 }
 
-void RealtimeFFT::cooleyTukeyFFT(std::vector<std::complex<float>>& data) {
-    bitReversalPermutation(data);
+void RealtimeFFT::setSlidingFrequencies(const std::vector<float>& frequencies, float damping) {
+    if (frequencies.empty()) {
+        m_sliding.reset();
+        m_triggered.clear();
+        return;
+    }
+    for (float frequency : frequencies) {
+        if (!(frequency >= 0.0f && frequency < m_sampleRate / 2)) {
+            throw std::invalid_argument("Sliding frequencies must be below the Nyquist frequency");
+        }
+    }
+    auto sliding = std::make_unique<esphome::realtime_fft::SlidingDFT>(
+        static_cast<int>(m_sampleRate), m_fftSize, frequencies, damping);
+    if (!sliding->is_valid()) {
+        throw std::invalid_argument("Damping must be between 0 and 1");
+    }
+    m_sliding = std::move(sliding);
+    m_triggered.assign(frequencies.size(), false);
+}
 
-    // Butterfly operations
-    for (int s = 1; s <= std::log2(m_fftSize); ++s) {
-        int m = 1 << s;
-        std::complex<float> wm = std::polar(1.0f, -2.0f * M_PI / m);
+void RealtimeFFT::setSpectrumFormat(SpectrumScale scale, float reference, float floorDb) {
+    if (!(reference > 0.0f)) {
+        throw std::invalid_argument("Reference level must be positive");
+    }
+    m_format = esphome::realtime_fft::SpectrumFormat(scale, reference, floorDb);
+}
 
-        for (int k = 0; k < m_fftSize; k += m) {
-            std::complex<float> w = 1.0f;
-            for (int j = 0; j < m/2; ++j) {
-                std::complex<float> t = w * data[k + j + m/2];
-                std::complex<float> u = data[k + j];
-                data[k + j] = u + t;
-                data[k + j + m/2] = u - t;
-                w *= wm;
-            }
-        }
+void RealtimeFFT::setHistory(size_t frames, HistoryDepth depth, float floorDb, float rangeDb) {
+    if (frames == 0) {
+        m_history.reset();
+        return;
     }
+    auto history = std::make_unique<SpectrogramHistory>(m_fftSize / 2, frames, depth, floorDb, rangeDb);
+    if (!history->is_valid()) {
+        throw std::invalid_argument("History range must be positive");
+    }
+    m_history = std::move(history);
+    m_historyFrames = 0;
+}
+
+void RealtimeFFT::setTrigger(float threshold, TriggerCallback callback) {
+    m_triggerThreshold = threshold;
+    m_triggerCallback = std::move(callback);
+    // Crossing states are only tracked while a callback is set, so a new one
+    // starts from "below" rather than from whatever an earlier one left
+    std::fill(m_triggered.begin(), m_triggered.end(), false);
 }
 
-void RealtimeFFT::bitReversalPermutation(std::vector<std::complex<float>>& data) {
-    for (int i = 0; i < m_fftSize; ++i) {
-        int rev = 0;
-        for (int j = 0; j < std::log2(m_fftSize); ++j) {
-            rev = (rev << 1) | (i >> j & 1);
+std::vector<float> RealtimeFFT::getSlidingMagnitudes() const {
+    std::vector<float> result;
+    if (m_sliding) {
+        for (size_t i = 0; i < m_sliding->size(); ++i) {
+            result.push_back(m_sliding->magnitude(i));
         }
-        if (rev > i) {
-            std::swap(data[i], data[rev]);
+    }
+    return result;
+}
+
+void RealtimeFFT::pushSliding(const float* samples, size_t count) {
+    if (!m_triggerCallback) {
+        m_sliding->push(samples, count, m_channels);
+        return;
+    }
+    // One sample (frame of channels) at a time, to report crossings where they
+    // happen; compared as powers so no square root is taken per sample
+    const float thresholdPower = m_triggerThreshold * m_triggerThreshold;
+    for (size_t offset = 0; (offset + 1) * m_channels <= count; ++offset) {
+        m_sliding->push(samples + offset * m_channels, m_channels, m_channels);
+        for (size_t i = 0; i < m_triggered.size(); ++i) {
+            const bool above = m_sliding->power(i) > thresholdPower;
+            if (above && !m_triggered[i]) {
+                m_triggerCallback(*this, static_cast<int>(i), offset);
+            }
+            m_triggered[i] = above;
         }
     }
 }
 
+void RealtimeFFT::processFrame(const float* frame) {
+    // Windowed real-input FFT of every channel, two channels per complex
+    // transform, and the spectra (first half) in the configured format
+    m_fft.spectrum(frame, m_magnitudeSpectrum.data(), m_format);
+    if (m_history) {
+        m_history->append(m_magnitudeSpectrum.data(), m_format, m_historyFrames++);
+    }
+}
+
 std::vector<float> RealtimeFFT::getMagnitudeSpectrum() const {
     return m_magnitudeSpectrum;
 }
 
+size_t RealtimeFFT::getMagnitudeSpectrum(float* out, size_t capacity) const {
+    size_t count = std::min(capacity, m_magnitudeSpectrum.size());
+    std::copy_n(m_magnitudeSpectrum.begin(), count, out);
+    return count;
+}
+
+RealtimeFFT::SpectrumView RealtimeFFT::magnitudes() const {
+    return SpectrumView(m_magnitudeSpectrum.data(), m_magnitudeSpectrum.size());
+}
+
+RealtimeFFT::SpectrumView RealtimeFFT::magnitudes(int channel) const {
+    if (channel < 0 || channel >= m_channels) {
+        throw std::out_of_range("No such channel");
+    }
+    return SpectrumView(m_magnitudeSpectrum.data() + channel * (m_fftSize / 2), m_fftSize / 2);
+}
+
 std::vector<float> RealtimeFFT::getFrequencyBins() const {
     return m_frequencyBins;
 }
 
-std::vector<float> RealtimeFFT::findPeakFrequencies(int numPeaks) const {
-    std::vector<std::pair<float, float>> frequencyMagnitudes;
-    
-    // Create pairs of (frequency, magnitude)
-    for (size_t i = 0; i < m_frequencyBins.size(); ++i) {
-        frequencyMagnitudes.push_back({m_frequencyBins[i], m_magnitudeSpectrum[i]});
-    }
+RealtimeFFT::SpectrumView RealtimeFFT::frequencyBins() const {
+    return SpectrumView(m_frequencyBins.data(), m_frequencyBins.size());
+}
 
-    // Sort by magnitude in descending order
-    std::sort(frequencyMagnitudes.begin(), frequencyMagnitudes.end(), 
-        [](const auto& a, const auto& b) { return a.second > b.second; });
+std::vector<float> RealtimeFFT::findPeakFrequencies(int numPeaks, int minSpacing, int channel) const {
+    SpectrumView spectrum = magnitudes(channel);
+
+    // One pass over the spectrum with a bounded heap, refined with the complex bins
+    esphome::realtime_fft::PeakFinder finder(std::max(numPeaks, 0), std::max(minSpacing, 1));
+    finder.set_format(m_format);
+    if (m_format.scale() == esphome::realtime_fft::SPECTRUM_DB) {
+        finder.set_threshold(m_format.floor_db());
+    }
+    finder.find(spectrum.data(), m_fft.real(channel), m_fft.imag(channel), spectrum.size());
 
-    // Extract top frequencies
     std::vector<float> peakFrequencies;
-    for (int i = 0; i < std::min(numPeaks, static_cast<int>(frequencyMagnitudes.size())); ++i) {
-        peakFrequencies.push_back(frequencyMagnitudes[i].first);
+    peakFrequencies.reserve(finder.size());
+    for (size_t i = 0; i < finder.size(); ++i) {
+        peakFrequencies.push_back(finder[i].bin * (m_sampleRate / m_fftSize));
     }
 
     return peakFrequencies;
@@ -0,0 +1,76 @@
+#include "activity_gate.h"
+#include <cmath>
+
+namespace esphome {
+namespace realtime_fft {
+
+template<typename T> static constexpr float full_scale() { return 1.0f; }
+template<> constexpr float full_scale<int16_t>() { return 1.0f / 32768.0f; }
+template<> constexpr float full_scale<int32_t>() { return 1.0f / 2147483648.0f; }
+
+// Threshold in dBFS as the detector measures it
+static float detector_level(GateDetector detector, float db) {
+  return detector == GATE_DETECTOR_RMS ? powf(10.0f, db / 10.0f) : powf(10.0f, db / 20.0f);
+}
+
+ActivityGate::ActivityGate(GateDetector detector, float open_db, float close_db, uint32_t hold_blocks,
+                           uint32_t keepalive_blocks)
+    : detector_(detector),
+      open_level_(detector_level(detector, open_db)),
+      close_level_(detector_level(detector, close_db)),
+      hold_blocks_(hold_blocks),
+      keepalive_blocks_(keepalive_blocks) {}
+
+float ActivityGate::level_db() const {
+  const float level = this->level_.load(std::memory_order_relaxed) + 1e-20f;
+  return this->detector_ == GATE_DETECTOR_RMS ? 10.0f * log10f(level) : 20.0f * log10f(level);
+}
+
+template<typename T> GateAction ActivityGate::update(const T *samples, size_t count) {
+  // Raw samples, scaled once for the whole block
+  float level = 0.0f;
+  if (this->detector_ == GATE_DETECTOR_RMS) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+      const float x = samples[i];
+      sum += x * x;
+    }
+    level = count > 0 ? sum / count * (full_scale<T>() * full_scale<T>()) : 0.0f;
+  } else {
+    float peak = 0.0f;
+    for (size_t i = 0; i < count; i++)
+      peak = fmaxf(peak, fabsf(static_cast<float>(samples[i])));
+    level = peak * full_scale<T>();
+  }
+  this->level_.store(level, std::memory_order_relaxed);
+  this->blocks_.fetch_add(1, std::memory_order_relaxed);
+
+  // Only this task writes open_, so it is read once and stored on change
+  const bool open = this->open_.load(std::memory_order_relaxed);
+  if (level >= (open ? this->close_level_ : this->open_level_)) {
+    this->open_.store(true, std::memory_order_relaxed);
+    this->quiet_ = 0;
+    return GATE_PASS;
+  }
+  if (open) {
+    // Held open through short pauses
+    if (++this->quiet_ <= this->hold_blocks_)
+      return GATE_PASS;
+    this->open_.store(false, std::memory_order_relaxed);
+    this->since_keepalive_ = 0;
+  }
+  if (this->keepalive_blocks_ != 0 && ++this->since_keepalive_ >= this->keepalive_blocks_) {
+    this->since_keepalive_ = 0;
+    this->keepalives_.fetch_add(1, std::memory_order_relaxed);
+    return GATE_KEEPALIVE;
+  }
+  this->skipped_.fetch_add(1, std::memory_order_relaxed);
+  return GATE_SKIP;
+}
+
+template GateAction ActivityGate::update<float>(const float *, size_t);
+template GateAction ActivityGate::update<int16_t>(const int16_t *, size_t);
+template GateAction ActivityGate::update<int32_t>(const int32_t *, size_t);
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Level measured over each block of samples
+enum GateDetector : uint8_t {
+  GATE_DETECTOR_RMS = 0,
+  // Largest absolute sample, so single clicks open the gate too
+  GATE_DETECTOR_PEAK,
+};
+
+// What to do with a block
+enum GateAction : uint8_t {
+  GATE_PASS = 0,
+  // Closed, but due for one of the reduced-rate frames
+  GATE_KEEPALIVE,
+  GATE_SKIP,
+};
+
+// Time-domain activity gate deciding, block by block, whether the input is
+// worth transforming.
+//
+// Every block is reduced to one level in a single pass over the raw samples
+// (a sum of squares or a running maximum, compared in the linear domain so
+// there is no log or square root per block). The gate opens as soon as a
+// block reaches open_db and closes once hold_blocks consecutive blocks stayed
+// below close_db; close_db under open_db gives the hysteresis that keeps a
+// level hovering at the threshold from toggling it. While closed, every
+// keepalive_blocks-th block passes anyway (0 = none), so consumers still see
+// an occasional frame of the quiet input.
+//
+// Levels are in dB of full scale: integer samples are scaled so that full
+// scale is 1.0, as in the FFT paths. State, level and counters may be read
+// from another task while one task updates the gate.
+class ActivityGate {
+ public:
+  ActivityGate(GateDetector detector, float open_db, float close_db, uint32_t hold_blocks,
+               uint32_t keepalive_blocks = 0);
+
+  bool is_valid() const { return this->close_level_ <= this->open_level_; }
+  bool is_open() const { return this->open_.load(std::memory_order_relaxed); }
+  // Level of the last block, in dBFS
+  float level_db() const;
+
+  // Measures one block of count samples (all channels) and decides on it.
+  template<typename T> GateAction update(const T *samples, size_t count);
+
+  // Blocks seen, skipped, and passed as keepalive frames
+  uint32_t blocks() const { return this->blocks_.load(std::memory_order_relaxed); }
+  uint32_t skipped_blocks() const { return this->skipped_.load(std::memory_order_relaxed); }
+  uint32_t keepalive_blocks() const { return this->keepalives_.load(std::memory_order_relaxed); }
+
+ protected:
+  GateDetector detector_;
+  // Thresholds as the detector measures them: mean square for RMS, amplitude for peak
+  float open_level_;
+  float close_level_;
+  uint32_t hold_blocks_;
+  uint32_t keepalive_blocks_;
+
+  // Written by the updating task, read by is_open()/level_db() from any task
+  std::atomic<bool> open_{false};
+  std::atomic<float> level_{0.0f};
+  // Quiet blocks in a row while open, and blocks since the last keepalive while closed
+  uint32_t quiet_{0};
+  uint32_t since_keepalive_{0};
+
+  std::atomic<uint32_t> blocks_{0};
+  std::atomic<uint32_t> skipped_{0};
+  std::atomic<uint32_t> keepalives_{0};
+};
+
+extern template GateAction ActivityGate::update<float>(const float *, size_t);
+extern template GateAction ActivityGate::update<int16_t>(const int16_t *, size_t);
+extern template GateAction ActivityGate::update<int32_t>(const int32_t *, size_t);
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,202 @@
+#include "audio_source.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+namespace esphome {
+namespace realtime_fft {
+
+static int64_t now_us() {
+#ifdef ESP_PLATFORM
+  return esp_timer_get_time();
+#else
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+size_t sample_format_size(SampleFormat format) {
+  switch (format) {
+    case SAMPLE_FORMAT_S16:
+      return sizeof(int16_t);
+    case SAMPLE_FORMAT_S32:
+      return sizeof(int32_t);
+    default:
+      return sizeof(float);
+  }
+}
+
+void encode_sample(double v, SampleFormat format, uint8_t *dst) {
+  v = std::max(-1.0, std::min(v, 1.0));
+  switch (format) {
+    case SAMPLE_FORMAT_S16: {
+      const int16_t s = static_cast<int16_t>(std::max(-32768.0, std::min(std::round(v * 32768.0), 32767.0)));
+      std::memcpy(dst, &s, sizeof(s));
+      break;
+    }
+    case SAMPLE_FORMAT_S32: {
+      const int32_t s =
+          static_cast<int32_t>(std::max(-2147483648.0, std::min(std::round(v * 2147483648.0), 2147483647.0)));
+      std::memcpy(dst, &s, sizeof(s));
+      break;
+    }
+    default: {
+      const float s = static_cast<float>(v);
+      std::memcpy(dst, &s, sizeof(s));
+      break;
+    }
+  }
+}
+
+bool AudioSource::open(SampleFormat format, int sample_rate, int channels) {
+  this->format_ = format;
+  this->sample_rate_ = sample_rate;
+  this->channels_ = channels;
+  this->next_due_us_ = 0;
+  return sample_rate > 0 && channels > 0;
+}
+
+void AudioSource::pace(size_t frames) {
+  if (!this->realtime_)
+    return;
+  const int64_t now = now_us();
+  if (this->next_due_us_ == 0 || this->next_due_us_ < now - 1000000) {
+    // First read, or we fell more than a second behind: restart the clock
+    this->next_due_us_ = now;
+  }
+  this->next_due_us_ += static_cast<int64_t>(frames) * 1000000 / this->sample_rate_;
+  const int64_t wait = this->next_due_us_ - now;
+  if (wait <= 0)
+    return;
+#ifdef ESP_PLATFORM
+  vTaskDelay(std::max<TickType_t>(1, pdMS_TO_TICKS(wait / 1000)));
+#else
+  std::this_thread::sleep_for(std::chrono::microseconds(wait));
+#endif
+}
+
+SyntheticAudioSource::SyntheticAudioSource(uint32_t seed) : seed_(seed != 0 ? seed : 1), state_(seed_) {
+  this->realtime_ = true;
+}
+
+void SyntheticAudioSource::add_tone(float frequency, float amplitude, int channel) {
+  this->tones_.push_back(Tone{frequency, amplitude, channel, 0.0});
+}
+
+void SyntheticAudioSource::set_chirp(float start_frequency, float end_frequency, uint32_t duration_ms,
+                                     float amplitude) {
+  this->chirp_start_ = start_frequency;
+  this->chirp_end_ = end_frequency;
+  this->chirp_duration_ms_ = duration_ms;
+  this->chirp_amplitude_ = amplitude;
+}
+
+bool SyntheticAudioSource::open(SampleFormat format, int sample_rate, int channels) {
+  // Reopening replays the exact same signal
+  this->state_ = this->seed_;
+  for (Tone &tone : this->tones_)
+    tone.phase = 0.0;
+  this->chirp_phase_ = 0.0;
+  this->chirp_sample_ = 0;
+  std::fill(std::begin(this->pink_), std::end(this->pink_), 0.0f);
+  this->frame_.assign(channels > 0 ? channels : 1, 0.0f);
+  return AudioSource::open(format, sample_rate, channels);
+}
+
+float SyntheticAudioSource::next_noise() {
+  // xorshift32, mapped to [-1, 1)
+  uint32_t x = this->state_;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  this->state_ = x;
+  return static_cast<int32_t>(x) * (1.0f / 2147483648.0f);
+}
+
+double SyntheticAudioSource::next_tone(Tone &tone) {
+  const double two_pi = 2.0 * M_PI;
+  const double v = tone.amplitude * std::sin(tone.phase);
+  tone.phase = std::fmod(tone.phase + two_pi * tone.frequency / this->sample_rate_, two_pi);
+  return v;
+}
+
+double SyntheticAudioSource::next_common() {
+  const double two_pi = 2.0 * M_PI;
+  double v = 0.0;
+  if (this->chirp_amplitude_ > 0.0f && this->chirp_duration_ms_ > 0) {
+    const uint64_t length = static_cast<uint64_t>(this->chirp_duration_ms_) * this->sample_rate_ / 1000;
+    const double t = length > 0 ? static_cast<double>(this->chirp_sample_) / length : 0.0;
+    const double frequency = this->chirp_start_ + (this->chirp_end_ - this->chirp_start_) * t;
+    v += this->chirp_amplitude_ * std::sin(this->chirp_phase_);
+    this->chirp_phase_ = std::fmod(this->chirp_phase_ + two_pi * frequency / this->sample_rate_, two_pi);
+    if (++this->chirp_sample_ >= length) {
+      this->chirp_sample_ = 0;
+      this->chirp_phase_ = 0.0;
+    }
+  }
+  if (this->white_amplitude_ > 0.0f)
+    v += this->white_amplitude_ * this->next_noise();
+  if (this->pink_amplitude_ > 0.0f) {
+    // Three-pole approximation of a -3 dB/octave slope, roughly unit peak level
+    const float white = this->next_noise();
+    this->pink_[0] = 0.99765f * this->pink_[0] + white * 0.0990460f;
+    this->pink_[1] = 0.96300f * this->pink_[1] + white * 0.2965164f;
+    this->pink_[2] = 0.57000f * this->pink_[2] + white * 1.0526913f;
+    const float pink = this->pink_[0] + this->pink_[1] + this->pink_[2] + white * 0.1848f;
+    v += this->pink_amplitude_ * 0.25f * pink;
+  }
+  return v;
+}
+
+float SyntheticAudioSource::next_sample() {
+  double v = this->next_common();
+  for (Tone &tone : this->tones_)
+    v += this->next_tone(tone);
+  return static_cast<float>(v);
+}
+
+void SyntheticAudioSource::next_frame(float *out) {
+  std::fill(out, out + this->channels_, static_cast<float>(this->next_common()));
+  for (Tone &tone : this->tones_) {
+    const float v = static_cast<float>(this->next_tone(tone));
+    if (tone.channel < 0) {
+      for (int c = 0; c < this->channels_; c++)
+        out[c] += v;
+    } else if (tone.channel < this->channels_) {
+      out[tone.channel] += v;
+    }
+  }
+}
+
+size_t SyntheticAudioSource::read(uint8_t *dst, size_t max_bytes) {
+  const size_t sample_size = sample_format_size(this->format_);
+  const size_t frame_bytes = sample_size * this->channels_;
+  const size_t count = max_bytes / frame_bytes;
+  for (size_t i = 0; i < count; i++) {
+    this->next_frame(this->frame_.data());
+    for (int c = 0; c < this->channels_; c++)
+      encode_sample(this->frame_[c], this->format_, dst + i * frame_bytes + c * sample_size);
+  }
+  this->pace(count);
+  return count * frame_bytes;
+}
+
+#ifdef ESP_PLATFORM
+size_t I2SAudioSource::read(uint8_t *dst, size_t max_bytes) {
+  size_t bytes_read = 0;
+  i2s_read(this->port_, dst, max_bytes, &bytes_read, portMAX_DELAY);
+  return bytes_read;
+}
+#endif
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef ESP_PLATFORM
+#include "driver/i2s.h"
+#endif
+
+namespace esphome {
+namespace realtime_fft {
+
+// Sample encoding handed to the pipeline, native endianness; several channels
+// are interleaved one sample frame at a time
+enum SampleFormat : uint8_t {
+  SAMPLE_FORMAT_FLOAT32 = 0,
+  SAMPLE_FORMAT_S16,
+  SAMPLE_FORMAT_S32,
+};
+
+size_t sample_format_size(SampleFormat format);
+// Writes v (full scale = 1.0, clamped) as one sample in format.
+void encode_sample(double v, SampleFormat format, uint8_t *dst);
+
+// Where the capture task gets its audio from.
+//
+// A source is opened once with the format, rate and channel count the pipeline
+// runs at, then
+// read() is called over and over from the capture task. Reads may block (I2S
+// DMA) or be paced to real time; sources that can run faster than real time
+// (files on a host) do so unless set_realtime(true) is called.
+class AudioSource {
+ public:
+  virtual ~AudioSource() = default;
+
+  // Prepares to deliver interleaved channels in format at sample_rate; false if it can't.
+  virtual bool open(SampleFormat format, int sample_rate, int channels = 1);
+  // Fills dst with up to max_bytes of whole sample frames. Returns the bytes
+  // produced, 0 once a finite source is exhausted.
+  virtual size_t read(uint8_t *dst, size_t max_bytes) = 0;
+  virtual const char *name() const = 0;
+
+  void set_realtime(bool realtime) { this->realtime_ = realtime; }
+  int channels() const { return this->channels_; }
+
+ protected:
+  // Sleeps until the sample frames delivered so far are due, when pacing to real time.
+  void pace(size_t frames);
+
+  SampleFormat format_{SAMPLE_FORMAT_FLOAT32};
+  int sample_rate_{44100};
+  int channels_{1};
+  bool realtime_{false};
+  int64_t next_due_us_{0};
+};
+
+// Test signal generator: any mix of tones, a repeating linear chirp, and white
+// and pink noise. Noise comes from a seeded xorshift generator, so a given
+// configuration produces the same samples on every run and every platform.
+// Paced to real time by default, like a microphone. With several channels the
+// chirp and noise are common to all of them and each tone goes to one channel
+// or to all.
+class SyntheticAudioSource : public AudioSource {
+ public:
+  explicit SyntheticAudioSource(uint32_t seed = 1);
+
+  // channel < 0 puts the tone on every channel.
+  void add_tone(float frequency, float amplitude, int channel = -1);
+  // Sweeps start..end Hz over duration_ms, then starts over.
+  void set_chirp(float start_frequency, float end_frequency, uint32_t duration_ms, float amplitude);
+  void set_white_noise(float amplitude) { this->white_amplitude_ = amplitude; }
+  void set_pink_noise(float amplitude) { this->pink_amplitude_ = amplitude; }
+
+  bool open(SampleFormat format, int sample_rate, int channels = 1) override;
+  size_t read(uint8_t *dst, size_t max_bytes) override;
+  const char *name() const override { return "synthetic"; }
+
+  // Next sample as a float with every tone mixed in, for callers that don't
+  // need the byte stream.
+  float next_sample();
+  // Next sample frame, one float per channel.
+  void next_frame(float *out);
+
+ protected:
+  struct Tone {
+    float frequency;
+    float amplitude;
+    int channel;
+    double phase;
+  };
+
+  float next_noise();
+  // Chirp and noise, shared by all channels
+  double next_common();
+  double next_tone(Tone &tone);
+
+  uint32_t seed_;
+  uint32_t state_;
+  std::vector<Tone> tones_;
+  float chirp_start_{0.0f};
+  float chirp_end_{0.0f};
+  uint32_t chirp_duration_ms_{0};
+  float chirp_amplitude_{0.0f};
+  double chirp_phase_{0.0};
+  uint64_t chirp_sample_{0};
+  float white_amplitude_{0.0f};
+  float pink_amplitude_{0.0f};
+  // Paul Kellet's pink noise filter state
+  float pink_[3]{};
+  // One sample frame, for read()
+  std::vector<float> frame_;
+};
+
+#ifdef ESP_PLATFORM
+// Reads the I2S DMA buffers, blocking until data is available. The port must
+// already be configured for the requested sample format.
+class I2SAudioSource : public AudioSource {
+ public:
+  explicit I2SAudioSource(i2s_port_t port) : port_(port) {}
+
+  size_t read(uint8_t *dst, size_t max_bytes) override;
+  const char *name() const override { return "i2s"; }
+
+ protected:
+  i2s_port_t port_;
+};
+#endif
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,115 @@
+#include "band_engine.h"
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace realtime_fft {
+
+static float hz_to_mel(float hz) { return 2595.0f * std::log10(1.0f + hz / 700.0f); }
+static float mel_to_hz(float mel) { return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f); }
+
+BandEngine::BandEngine(int sample_rate, size_t fft_size, BandScale scale, size_t band_count, float min_frequency,
+                       float max_frequency)
+    : bin_width_(static_cast<float>(sample_rate) / fft_size), bin_count_(fft_size / 2) {
+  const float nyquist = sample_rate / 2.0f;
+  max_frequency = std::min(max_frequency, nyquist);
+  min_frequency = std::max(min_frequency, 0.0f);
+  if (sample_rate <= 0 || this->bin_count_ < 2 || this->bin_count_ > 65536 || min_frequency >= max_frequency)
+    return;
+
+  switch (scale) {
+    case BAND_SCALE_OCTAVE:
+    case BAND_SCALE_THIRD_OCTAVE: {
+      const float fraction = scale == BAND_SCALE_OCTAVE ? 1.0f : 3.0f;
+      const float half_width = std::pow(2.0f, 0.5f / fraction);
+      // Band index relative to 1 kHz, rounded inward so centres stay in range
+      const int first = static_cast<int>(std::ceil(fraction * std::log2(std::max(min_frequency, 1.0f) / 1000.0f)));
+      const int last = static_cast<int>(std::floor(fraction * std::log2(max_frequency / 1000.0f)));
+      for (int n = first; n <= last && this->centers_.size() < 256; n++) {
+        const float center = 1000.0f * std::pow(2.0f, n / fraction);
+        const uint8_t band = static_cast<uint8_t>(this->centers_.size());
+        this->centers_.push_back(center);
+        this->add_rectangular(band, center / half_width, std::min(center * half_width, nyquist));
+      }
+      break;
+    }
+    case BAND_SCALE_MEL: {
+      // band_count triangles need band_count + 2 equally spaced mel points
+      const float low = hz_to_mel(min_frequency), high = hz_to_mel(max_frequency);
+      const float step = (high - low) / (band_count + 1);
+      for (size_t b = 0; b < band_count && b < 256; b++) {
+        const float center = mel_to_hz(low + (b + 1) * step);
+        this->centers_.push_back(center);
+        this->add_triangular(b, mel_to_hz(low + b * step), center, mel_to_hz(low + (b + 2) * step));
+      }
+      break;
+    }
+    case BAND_SCALE_LOG: {
+      // A 0 Hz lower edge has no logarithm; start at the first bin instead
+      const float low = std::max(min_frequency, this->bin_width_ / 2);
+      const float ratio = std::pow(max_frequency / low, 1.0f / band_count);
+      for (size_t b = 0; b < band_count && b < 256; b++) {
+        const float lower = low * std::pow(ratio, static_cast<float>(b));
+        this->centers_.push_back(lower * std::sqrt(ratio));
+        this->add_rectangular(b, lower, lower * ratio);
+      }
+      break;
+    }
+  }
+
+  // Walk the spectrum in order when reducing
+  std::sort(this->weights_.begin(), this->weights_.end(),
+            [](const Weight &a, const Weight &b) { return a.bin < b.bin || (a.bin == b.bin && a.band < b.band); });
+}
+
+void BandEngine::add_rectangular(uint8_t band, float low, float high) {
+  // Bin k covers [k - 0.5, k + 0.5] bin widths
+  const float lo = low / this->bin_width_, hi = high / this->bin_width_;
+  const size_t first = static_cast<size_t>(std::max(0.0f, std::floor(lo + 0.5f)));
+  const size_t last = std::min(static_cast<size_t>(std::max(0.0f, std::floor(hi + 0.5f))), this->bin_count_ - 1);
+  for (size_t k = first; k <= last; k++) {
+    const float overlap = std::min(hi, k + 0.5f) - std::max(lo, k - 0.5f);
+    if (overlap > 0.0f)
+      this->weights_.push_back(Weight{static_cast<uint16_t>(k), band, overlap});
+  }
+}
+
+void BandEngine::add_triangular(uint8_t band, float low, float center, float high) {
+  const size_t before = this->weights_.size();
+  const size_t first = static_cast<size_t>(std::ceil(low / this->bin_width_));
+  const size_t last = std::min(static_cast<size_t>(high / this->bin_width_), this->bin_count_ - 1);
+  for (size_t k = first; k <= last; k++) {
+    const float f = k * this->bin_width_;
+    const float weight = f <= center ? (f - low) / (center - low) : (high - f) / (high - center);
+    if (weight > 0.0f)
+      this->weights_.push_back(Weight{static_cast<uint16_t>(k), band, weight});
+  }
+  // Low mel bands can be narrower than a bin; keep them fed from the nearest one
+  if (this->weights_.size() == before) {
+    const size_t k = std::min(static_cast<size_t>(std::lround(center / this->bin_width_)), this->bin_count_ - 1);
+    this->weights_.push_back(Weight{static_cast<uint16_t>(k), band, 1.0f});
+  }
+}
+
+void BandEngine::compute(const float *spectrum, float *energies, const SpectrumFormat &format) const {
+  std::fill(energies, energies + this->centers_.size(), 0.0f);
+  switch (format.scale()) {
+    case SPECTRUM_POWER:
+      for (const Weight &w : this->weights_)
+        energies[w.band] += w.weight * spectrum[w.bin];
+      break;
+    case SPECTRUM_DB:
+      for (const Weight &w : this->weights_)
+        energies[w.band] += w.weight * format.to_power(spectrum[w.bin]);
+      break;
+    default:
+      for (const Weight &w : this->weights_) {
+        const float m = spectrum[w.bin];
+        energies[w.band] += w.weight * m * m;
+      }
+      break;
+  }
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
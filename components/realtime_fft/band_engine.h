@@ -0,0 +1,65 @@
+#pragma once
+
+#include "spectrum_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// How the spectrum is split into bands
+enum BandScale : uint8_t {
+  // Base-2 octave and 1/3-octave bands on the 1 kHz grid (IEC 61260 centres)
+  BAND_SCALE_OCTAVE = 0,
+  BAND_SCALE_THIRD_OCTAVE,
+  // Overlapping triangular filters evenly spaced on the mel scale
+  BAND_SCALE_MEL,
+  // Adjacent bands with logarithmically spaced edges
+  BAND_SCALE_LOG,
+};
+
+// Reduces a spectrum to per-band energies.
+//
+// The bin-to-band weights are worked out once for a (sample rate, FFT size,
+// layout) and stored sparsely, ordered by bin, so compute() is a single pass
+// over the spectrum with one multiply-add per weight. Rectangular bands weight
+// each bin by the fraction of its width inside the band, so adjacent bands
+// share edge bins instead of double-counting them; bands narrower than a bin
+// still see the bin they fall in.
+class BandEngine {
+ public:
+  // Octave scales use every standard band whose centre lies in
+  // [min_frequency, max_frequency] and ignore band_count; mel and log use
+  // band_count bands spanning that range. max_frequency is capped at Nyquist.
+  BandEngine(int sample_rate, size_t fft_size, BandScale scale, size_t band_count, float min_frequency,
+             float max_frequency);
+
+  bool is_valid() const { return !this->centers_.empty(); }
+  size_t band_count() const { return this->centers_.size(); }
+  float center_frequency(size_t band) const { return this->centers_[band]; }
+  size_t weight_count() const { return this->weights_.size(); }
+
+  // energies[b] = sum of weight * |X|^2 over the bins of band b; spectrum
+  // holds fft_size / 2 bins in the given format. Power spectra are summed as
+  // they are, dB bins pay one exponential each.
+  void compute(const float *spectrum, float *energies, const SpectrumFormat &format = SpectrumFormat()) const;
+
+ protected:
+  struct Weight {
+    uint16_t bin;
+    uint8_t band;
+    float weight;
+  };
+
+  void add_rectangular(uint8_t band, float low, float high);
+  void add_triangular(uint8_t band, float low, float center, float high);
+
+  float bin_width_;
+  size_t bin_count_;
+  std::vector<float> centers_;
+  std::vector<Weight> weights_;
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
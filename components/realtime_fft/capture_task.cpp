@@ -0,0 +1,33 @@
+#include "capture_task.h"
+#include <utility>
+
+namespace esphome {
+namespace realtime_fft {
+
+CaptureTask::CaptureTask(size_t ring_bytes, size_t chunk_bytes, uint8_t *ring_storage)
+    : ring_(ring_bytes, ring_storage), chunk_(chunk_bytes) {}
+
+bool CaptureTask::start(ReadFunction read, const char *name, int core, int priority) {
+  if (this->worker_.is_running())
+    return false;
+  this->read_ = std::move(read);
+  return this->worker_.start([this]() { this->read_chunk(); }, name, core, priority);
+}
+
+bool CaptureTask::start(AudioSource *source, const char *name, int core, int priority) {
+  return this->start([source](uint8_t *dst, size_t max_bytes) { return source->read(dst, max_bytes); }, name, core,
+                     priority);
+}
+
+void CaptureTask::read_chunk() {
+  size_t bytes = this->read_(this->chunk_.data(), this->chunk_.size());
+  if (bytes == 0) {
+    // Finite source ran dry; don't spin on it
+    WorkerTask::sleep_ms(1);
+  } else if (!this->ring_.push(this->chunk_.data(), bytes)) {
+    this->overruns_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "audio_source.h"
+#include "spsc_ring_buffer.h"
+#include "worker_task.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Runs audio acquisition in its own task and hands raw sample bytes to the
+// consumer through a lock-free ring buffer.
+//
+// The read function may block (e.g. i2s_read with portMAX_DELAY); only the
+// capture task waits on it. On ESP32 this is a FreeRTOS task, on hosts a
+// std::thread, so the same queue can be driven by a synthetic or file source on Linux.
+// Chunks that don't fit because the consumer fell behind are dropped whole and
+// counted as overruns.
+class CaptureTask {
+ public:
+  // Fills dst with up to max_bytes and returns the number of bytes produced.
+  using ReadFunction = std::function<size_t(uint8_t *dst, size_t max_bytes)>;
+
+  // chunk_bytes should be a multiple of the sample size so samples never split.
+  // ring_storage, if given, holds ring_storage_size(ring_bytes) bytes.
+  CaptureTask(size_t ring_bytes, size_t chunk_bytes, uint8_t *ring_storage = nullptr);
+
+  static size_t ring_storage_size(size_t ring_bytes) { return SpscRingBuffer<uint8_t>::storage_size(ring_bytes); }
+
+  bool start(ReadFunction read, const char *name = "fft_capture", int core = 0, int priority = 5);
+  // Reads from an opened source, which must outlive the task.
+  bool start(AudioSource *source, const char *name = "fft_capture", int core = 0, int priority = 5);
+  // On hosts this joins the thread; on ESP32 the task exits after its current
+  // read, so the object must outlive that read.
+  void stop() { this->worker_.stop(); }
+
+  SpscRingBuffer<uint8_t> &buffer() { return this->ring_; }
+  uint32_t get_overruns() const { return this->overruns_.load(std::memory_order_relaxed); }
+
+ protected:
+  void read_chunk();
+
+  SpscRingBuffer<uint8_t> ring_;
+  std::vector<uint8_t> chunk_;
+  ReadFunction read_;
+  std::atomic<uint32_t> overruns_{0};
+  // Last member, so the task is stopped before the buffers it uses go away
+  WorkerTask worker_;
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,229 @@
+#include "fft_kernels.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace esphome {
+namespace realtime_fft {
+
+static void radix4_scalar(float *real, float *imag, size_t n, size_t h, const float *w1r, const float *w1i,
+                          const float *w2r, const float *w2i) {
+  for (size_t k = 0; k < n; k += 4 * h) {
+    float *ar = real + k, *br = ar + h, *cr = br + h, *dr = cr + h;
+    float *ai = imag + k, *bi = ai + h, *ci = bi + h, *di = ci + h;
+    for (size_t j = 0; j < h; j++) {
+      // First stage: (a, b) and (c, d) with W_2h^j
+      float tr = w1r[j] * br[j] - w1i[j] * bi[j];
+      float ti = w1r[j] * bi[j] + w1i[j] * br[j];
+      const float a1r = ar[j] + tr, a1i = ai[j] + ti;
+      const float b1r = ar[j] - tr, b1i = ai[j] - ti;
+      tr = w1r[j] * dr[j] - w1i[j] * di[j];
+      ti = w1r[j] * di[j] + w1i[j] * dr[j];
+      const float c1r = cr[j] + tr, c1i = ci[j] + ti;
+      const float d1r = cr[j] - tr, d1i = ci[j] - ti;
+
+      // Second stage: (a, c) with W_4h^j and (b, d) with W_4h^(j+h)
+      tr = w2r[j] * c1r - w2i[j] * c1i;
+      ti = w2r[j] * c1i + w2i[j] * c1r;
+      ar[j] = a1r + tr;
+      ai[j] = a1i + ti;
+      cr[j] = a1r - tr;
+      ci[j] = a1i - ti;
+      tr = w2r[j + h] * d1r - w2i[j + h] * d1i;
+      ti = w2r[j + h] * d1i + w2i[j + h] * d1r;
+      br[j] = b1r + tr;
+      bi[j] = b1i + ti;
+      dr[j] = b1r - tr;
+      di[j] = b1i - ti;
+    }
+  }
+}
+
+Radix4Kernel radix4_scalar_kernel() { return {radix4_scalar, "scalar"}; }
+
+// The vector kernels spell out the scalar kernel lane by lane. They use separate
+// multiplies and adds (no FMA) so results stay bit-identical to radix4_scalar.
+
+#if defined(__SSE2__)
+static void radix4_sse2(float *real, float *imag, size_t n, size_t h, const float *w1r, const float *w1i,
+                        const float *w2r, const float *w2i) {
+  if (h < 4) {
+    radix4_scalar(real, imag, n, h, w1r, w1i, w2r, w2i);
+    return;
+  }
+  for (size_t k = 0; k < n; k += 4 * h) {
+    float *ar = real + k, *br = ar + h, *cr = br + h, *dr = cr + h;
+    float *ai = imag + k, *bi = ai + h, *ci = bi + h, *di = ci + h;
+    for (size_t j = 0; j < h; j += 4) {
+      __m128 wr = _mm_loadu_ps(w1r + j), wi = _mm_loadu_ps(w1i + j);
+      __m128 xr = _mm_loadu_ps(br + j), xi = _mm_loadu_ps(bi + j);
+      __m128 tr = _mm_sub_ps(_mm_mul_ps(wr, xr), _mm_mul_ps(wi, xi));
+      __m128 ti = _mm_add_ps(_mm_mul_ps(wr, xi), _mm_mul_ps(wi, xr));
+      __m128 yr = _mm_loadu_ps(ar + j), yi = _mm_loadu_ps(ai + j);
+      const __m128 a1r = _mm_add_ps(yr, tr), a1i = _mm_add_ps(yi, ti);
+      const __m128 b1r = _mm_sub_ps(yr, tr), b1i = _mm_sub_ps(yi, ti);
+      xr = _mm_loadu_ps(dr + j);
+      xi = _mm_loadu_ps(di + j);
+      tr = _mm_sub_ps(_mm_mul_ps(wr, xr), _mm_mul_ps(wi, xi));
+      ti = _mm_add_ps(_mm_mul_ps(wr, xi), _mm_mul_ps(wi, xr));
+      yr = _mm_loadu_ps(cr + j);
+      yi = _mm_loadu_ps(ci + j);
+      const __m128 c1r = _mm_add_ps(yr, tr), c1i = _mm_add_ps(yi, ti);
+      const __m128 d1r = _mm_sub_ps(yr, tr), d1i = _mm_sub_ps(yi, ti);
+
+      wr = _mm_loadu_ps(w2r + j);
+      wi = _mm_loadu_ps(w2i + j);
+      tr = _mm_sub_ps(_mm_mul_ps(wr, c1r), _mm_mul_ps(wi, c1i));
+      ti = _mm_add_ps(_mm_mul_ps(wr, c1i), _mm_mul_ps(wi, c1r));
+      _mm_storeu_ps(ar + j, _mm_add_ps(a1r, tr));
+      _mm_storeu_ps(ai + j, _mm_add_ps(a1i, ti));
+      _mm_storeu_ps(cr + j, _mm_sub_ps(a1r, tr));
+      _mm_storeu_ps(ci + j, _mm_sub_ps(a1i, ti));
+      wr = _mm_loadu_ps(w2r + h + j);
+      wi = _mm_loadu_ps(w2i + h + j);
+      tr = _mm_sub_ps(_mm_mul_ps(wr, d1r), _mm_mul_ps(wi, d1i));
+      ti = _mm_add_ps(_mm_mul_ps(wr, d1i), _mm_mul_ps(wi, d1r));
+      _mm_storeu_ps(br + j, _mm_add_ps(b1r, tr));
+      _mm_storeu_ps(bi + j, _mm_add_ps(b1i, ti));
+      _mm_storeu_ps(dr + j, _mm_sub_ps(b1r, tr));
+      _mm_storeu_ps(di + j, _mm_sub_ps(b1i, ti));
+    }
+  }
+}
+
+// Compiled for AVX2 regardless of the build flags and only selected after a
+// CPUID check. "fma" is deliberately left out of the target list.
+__attribute__((target("avx2"))) static void radix4_avx2(float *real, float *imag, size_t n, size_t h,
+                                                        const float *w1r, const float *w1i, const float *w2r,
+                                                        const float *w2i) {
+  if (h < 8) {
+    radix4_sse2(real, imag, n, h, w1r, w1i, w2r, w2i);
+    return;
+  }
+  for (size_t k = 0; k < n; k += 4 * h) {
+    float *ar = real + k, *br = ar + h, *cr = br + h, *dr = cr + h;
+    float *ai = imag + k, *bi = ai + h, *ci = bi + h, *di = ci + h;
+    for (size_t j = 0; j < h; j += 8) {
+      __m256 wr = _mm256_loadu_ps(w1r + j), wi = _mm256_loadu_ps(w1i + j);
+      __m256 xr = _mm256_loadu_ps(br + j), xi = _mm256_loadu_ps(bi + j);
+      __m256 tr = _mm256_sub_ps(_mm256_mul_ps(wr, xr), _mm256_mul_ps(wi, xi));
+      __m256 ti = _mm256_add_ps(_mm256_mul_ps(wr, xi), _mm256_mul_ps(wi, xr));
+      __m256 yr = _mm256_loadu_ps(ar + j), yi = _mm256_loadu_ps(ai + j);
+      const __m256 a1r = _mm256_add_ps(yr, tr), a1i = _mm256_add_ps(yi, ti);
+      const __m256 b1r = _mm256_sub_ps(yr, tr), b1i = _mm256_sub_ps(yi, ti);
+      xr = _mm256_loadu_ps(dr + j);
+      xi = _mm256_loadu_ps(di + j);
+      tr = _mm256_sub_ps(_mm256_mul_ps(wr, xr), _mm256_mul_ps(wi, xi));
+      ti = _mm256_add_ps(_mm256_mul_ps(wr, xi), _mm256_mul_ps(wi, xr));
+      yr = _mm256_loadu_ps(cr + j);
+      yi = _mm256_loadu_ps(ci + j);
+      const __m256 c1r = _mm256_add_ps(yr, tr), c1i = _mm256_add_ps(yi, ti);
+      const __m256 d1r = _mm256_sub_ps(yr, tr), d1i = _mm256_sub_ps(yi, ti);
+
+      wr = _mm256_loadu_ps(w2r + j);
+      wi = _mm256_loadu_ps(w2i + j);
+      tr = _mm256_sub_ps(_mm256_mul_ps(wr, c1r), _mm256_mul_ps(wi, c1i));
+      ti = _mm256_add_ps(_mm256_mul_ps(wr, c1i), _mm256_mul_ps(wi, c1r));
+      _mm256_storeu_ps(ar + j, _mm256_add_ps(a1r, tr));
+      _mm256_storeu_ps(ai + j, _mm256_add_ps(a1i, ti));
+      _mm256_storeu_ps(cr + j, _mm256_sub_ps(a1r, tr));
+      _mm256_storeu_ps(ci + j, _mm256_sub_ps(a1i, ti));
+      wr = _mm256_loadu_ps(w2r + h + j);
+      wi = _mm256_loadu_ps(w2i + h + j);
+      tr = _mm256_sub_ps(_mm256_mul_ps(wr, d1r), _mm256_mul_ps(wi, d1i));
+      ti = _mm256_add_ps(_mm256_mul_ps(wr, d1i), _mm256_mul_ps(wi, d1r));
+      _mm256_storeu_ps(br + j, _mm256_add_ps(b1r, tr));
+      _mm256_storeu_ps(bi + j, _mm256_add_ps(b1i, ti));
+      _mm256_storeu_ps(dr + j, _mm256_sub_ps(b1r, tr));
+      _mm256_storeu_ps(di + j, _mm256_sub_ps(b1i, ti));
+    }
+  }
+}
+#endif  // __SSE2__
+
+#if defined(__ARM_NEON)
+static void radix4_neon(float *real, float *imag, size_t n, size_t h, const float *w1r, const float *w1i,
+                        const float *w2r, const float *w2i) {
+  if (h < 4) {
+    radix4_scalar(real, imag, n, h, w1r, w1i, w2r, w2i);
+    return;
+  }
+  for (size_t k = 0; k < n; k += 4 * h) {
+    float *ar = real + k, *br = ar + h, *cr = br + h, *dr = cr + h;
+    float *ai = imag + k, *bi = ai + h, *ci = bi + h, *di = ci + h;
+    for (size_t j = 0; j < h; j += 4) {
+      float32x4_t wr = vld1q_f32(w1r + j), wi = vld1q_f32(w1i + j);
+      float32x4_t xr = vld1q_f32(br + j), xi = vld1q_f32(bi + j);
+      float32x4_t tr = vsubq_f32(vmulq_f32(wr, xr), vmulq_f32(wi, xi));
+      float32x4_t ti = vaddq_f32(vmulq_f32(wr, xi), vmulq_f32(wi, xr));
+      float32x4_t yr = vld1q_f32(ar + j), yi = vld1q_f32(ai + j);
+      const float32x4_t a1r = vaddq_f32(yr, tr), a1i = vaddq_f32(yi, ti);
+      const float32x4_t b1r = vsubq_f32(yr, tr), b1i = vsubq_f32(yi, ti);
+      xr = vld1q_f32(dr + j);
+      xi = vld1q_f32(di + j);
+      tr = vsubq_f32(vmulq_f32(wr, xr), vmulq_f32(wi, xi));
+      ti = vaddq_f32(vmulq_f32(wr, xi), vmulq_f32(wi, xr));
+      yr = vld1q_f32(cr + j);
+      yi = vld1q_f32(ci + j);
+      const float32x4_t c1r = vaddq_f32(yr, tr), c1i = vaddq_f32(yi, ti);
+      const float32x4_t d1r = vsubq_f32(yr, tr), d1i = vsubq_f32(yi, ti);
+
+      wr = vld1q_f32(w2r + j);
+      wi = vld1q_f32(w2i + j);
+      tr = vsubq_f32(vmulq_f32(wr, c1r), vmulq_f32(wi, c1i));
+      ti = vaddq_f32(vmulq_f32(wr, c1i), vmulq_f32(wi, c1r));
+      vst1q_f32(ar + j, vaddq_f32(a1r, tr));
+      vst1q_f32(ai + j, vaddq_f32(a1i, ti));
+      vst1q_f32(cr + j, vsubq_f32(a1r, tr));
+      vst1q_f32(ci + j, vsubq_f32(a1i, ti));
+      wr = vld1q_f32(w2r + h + j);
+      wi = vld1q_f32(w2i + h + j);
+      tr = vsubq_f32(vmulq_f32(wr, d1r), vmulq_f32(wi, d1i));
+      ti = vaddq_f32(vmulq_f32(wr, d1i), vmulq_f32(wi, d1r));
+      vst1q_f32(br + j, vaddq_f32(b1r, tr));
+      vst1q_f32(bi + j, vaddq_f32(b1i, ti));
+      vst1q_f32(dr + j, vsubq_f32(b1r, tr));
+      vst1q_f32(di + j, vsubq_f32(b1i, ti));
+    }
+  }
+}
+#endif  // __ARM_NEON
+
+Radix4Kernel select_radix4_kernel() {
+#if defined(__SSE2__)
+#if defined(__GNUC__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return {radix4_avx2, "avx2"};
+#endif
+  return {radix4_sse2, "sse2"};
+#elif defined(__ARM_NEON)
+  return {radix4_neon, "neon"};
+#else
+  // ESP32 targets: the S3 vector unit (PIE) has no float lanes, so float frames
+  // run the scalar kernel on the FPU.
+  return radix4_scalar_kernel();
+#endif
+}
+
+std::vector<Radix4Kernel> available_radix4_kernels() {
+  std::vector<Radix4Kernel> kernels{radix4_scalar_kernel()};
+#if defined(__SSE2__)
+  kernels.push_back({radix4_sse2, "sse2"});
+#if defined(__GNUC__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    kernels.push_back({radix4_avx2, "avx2"});
+#endif
+#elif defined(__ARM_NEON)
+  kernels.push_back({radix4_neon, "neon"});
+#endif
+  return kernels;
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
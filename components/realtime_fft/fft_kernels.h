@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// One radix-4 pass over split (structure-of-arrays) data of length n, fusing the
+// two radix-2 stages with half-lengths h and 2h. w1 holds W_2h^j for j < h and
+// w2 holds W_4h^j for j < 2h. The arithmetic matches two radix-2 passes exactly,
+// so every kernel produces the same bits as the scalar one.
+using Radix4Pass = void (*)(float *real, float *imag, size_t n, size_t h, const float *w1r, const float *w1i,
+                            const float *w2r, const float *w2i);
+
+struct Radix4Kernel {
+  Radix4Pass pass;
+  const char *name;
+};
+
+// Scalar reference kernel, always available.
+Radix4Kernel radix4_scalar_kernel();
+
+// Fastest kernel supported by the CPU we are running on; falls back to scalar.
+Radix4Kernel select_radix4_kernel();
+
+// Every kernel the CPU we are running on supports, scalar first, for tests and
+// benchmarks that compare them.
+std::vector<Radix4Kernel> available_radix4_kernels();
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,222 @@
+#include "fft_plan.h"
+#include <cmath>
+#include <utility>
+
+namespace esphome {
+namespace realtime_fft {
+
+void build_bit_reversal_swaps(size_t n, InternalVector<uint16_t> &swaps) {
+  int bits = 0;
+  while ((size_t(1) << bits) < n)
+    bits++;
+  for (size_t i = 0; i < n; i++) {
+    size_t rev = 0;
+    for (int b = 0; b < bits; b++)
+      rev |= ((i >> b) & 1) << (bits - 1 - b);
+    if (i < rev) {
+      swaps.push_back(static_cast<uint16_t>(i));
+      swaps.push_back(static_cast<uint16_t>(rev));
+    }
+  }
+}
+
+bool FFTPlan::is_power_of_two_size(size_t size) {
+  return size >= 2 && size <= 65536 && (size & (size - 1)) == 0;
+}
+
+bool FFTPlan::is_supported_size(size_t size) {
+  return is_power_of_two_size(size) || (size >= 4 && size <= 65536 && size % 2 == 0);
+}
+
+size_t FFTPlan::memory_bytes() const {
+  size_t bytes = (this->twiddle_re_.size() + this->twiddle_im_.size() + this->window_.size() + this->scratch_.size()) *
+                     sizeof(float) +
+                 (this->swaps_.size() + this->half_swaps_.size()) * sizeof(uint16_t);
+  if (this->mixed_ != nullptr)
+    bytes += this->mixed_->memory_bytes();
+  return bytes;
+}
+
+FFTPlan::FFTPlan(size_t size) : kernel_(select_radix4_kernel()) {
+  if (!is_supported_size(size))
+    return;
+  this->size_ = size;
+
+  // Hann window
+  this->window_.resize(size);
+  for (size_t i = 0; i < size; i++) {
+    this->window_[i] = static_cast<float>(0.5 * (1.0 - std::cos(2.0 * M_PI * i / (size - 1))));
+  }
+
+  if (!is_power_of_two_size(size)) {
+    this->mixed_.reset(new MixedRadixFFT(size / 2));
+    this->twiddle_re_.resize(size / 2 + 1);
+    this->twiddle_im_.resize(size / 2 + 1);
+    for (size_t k = 0; k <= size / 2; k++) {
+      double theta = -2.0 * M_PI * k / size;
+      this->twiddle_re_[k] = static_cast<float>(std::cos(theta));
+      this->twiddle_im_[k] = static_cast<float>(std::sin(theta));
+    }
+    this->scratch_.resize(size);
+    return;
+  }
+
+  // Twiddles are computed in double so that large sizes don't accumulate error;
+  // the quarter turn is exact so that it costs no rounding either
+  this->twiddle_re_.resize(size - 1);
+  this->twiddle_im_.resize(size - 1);
+  for (size_t h = 1; h < size; h *= 2) {
+    for (size_t j = 0; j < h; j++) {
+      double theta = -M_PI * j / h;
+      bool quarter = 2 * j == h;
+      this->twiddle_re_[h - 1 + j] = quarter ? 0.0f : static_cast<float>(std::cos(theta));
+      this->twiddle_im_[h - 1 + j] = quarter ? -1.0f : static_cast<float>(std::sin(theta));
+    }
+  }
+
+  build_bit_reversal_swaps(size, this->swaps_);
+  build_bit_reversal_swaps(size / 2, this->half_swaps_);
+}
+
+void FFTPlan::apply_window(const float *in, float *out) const {
+  for (size_t i = 0; i < this->size_; i++)
+    out[i] = in[i] * this->window_[i];
+}
+
+void FFTPlan::forward(float *real, float *imag) const {
+  if (this->mixed_ != nullptr) {
+    this->forward_mixed_(real, imag);
+    return;
+  }
+  this->transform_(real, imag, this->size_, this->swaps_);
+}
+
+// One radix-2 decimation step on top of the size/2 transform:
+// X[k] = E[k] + W^k O[k] and X[k + size/2] = E[k] - W^k O[k].
+void FFTPlan::forward_mixed_(float *real, float *imag) const {
+  const size_t m = this->size_ / 2;
+  // Odd samples go to scratch, even ones are compacted into the first half
+  float *odd_re = this->scratch_.data();
+  float *odd_im = odd_re + m;
+  for (size_t i = 0; i < m; i++) {
+    odd_re[i] = real[2 * i + 1];
+    odd_im[i] = imag[2 * i + 1];
+    real[i] = real[2 * i];
+    imag[i] = imag[2 * i];
+  }
+  this->mixed_->forward(real, imag);
+  this->mixed_->forward(odd_re, odd_im);
+  const float *wr = this->twiddle_re_.data(), *wi = this->twiddle_im_.data();
+  for (size_t k = 0; k < m; k++) {
+    const float tr = wr[k] * odd_re[k] - wi[k] * odd_im[k];
+    const float ti = wr[k] * odd_im[k] + wi[k] * odd_re[k];
+    real[k + m] = real[k] - tr;
+    imag[k + m] = imag[k] - ti;
+    real[k] += tr;
+    imag[k] += ti;
+  }
+}
+
+// Transform of length n <= size(); the stage tables are shared, so the same plan
+// serves the full complex and the half-size real path.
+void FFTPlan::transform_(float *real, float *imag, size_t n, const InternalVector<uint16_t> &swaps) const {
+  for (size_t s = 0; s < swaps.size(); s += 2) {
+    size_t a = swaps[s], b = swaps[s + 1];
+    std::swap(real[a], real[b]);
+    std::swap(imag[a], imag[b]);
+  }
+
+  // With an odd number of stages the first one is a twiddle-free radix-2 pass
+  size_t h = 1;
+  int stages = 0;
+  while ((size_t(1) << stages) < n)
+    stages++;
+  if (stages & 1) {
+    for (size_t k = 0; k < n; k += 2) {
+      const float tr = real[k + 1], ti = imag[k + 1];
+      real[k + 1] = real[k] - tr;
+      imag[k + 1] = imag[k] - ti;
+      real[k] += tr;
+      imag[k] += ti;
+    }
+    h = 2;
+  }
+
+  const float *wr = this->twiddle_re_.data();
+  const float *wi = this->twiddle_im_.data();
+  for (; 4 * h <= n; h *= 4)
+    this->kernel_.pass(real, imag, n, h, wr + h - 1, wi + h - 1, wr + 2 * h - 1, wi + 2 * h - 1);
+}
+
+void FFTPlan::pack_and_transform_(const float *in, float *real, float *imag, bool windowed) const {
+  const size_t m = this->size_ / 2;
+
+  // Pack even samples into the real part and odd samples into the imaginary part
+  if (windowed) {
+    const float *w = this->window_.data();
+    for (size_t i = 0; i < m; i++) {
+      real[i] = in[2 * i] * w[2 * i];
+      imag[i] = in[2 * i + 1] * w[2 * i + 1];
+    }
+  } else {
+    for (size_t i = 0; i < m; i++) {
+      real[i] = in[2 * i];
+      imag[i] = in[2 * i + 1];
+    }
+  }
+
+  if (this->mixed_ != nullptr) {
+    this->mixed_->forward(real, imag);
+  } else {
+    this->transform_(real, imag, m, this->half_swaps_);
+  }
+}
+
+// Split Z into the spectra of the even and odd samples and recombine:
+// X[k] = E[k] + W^k O[k] and X[m - k] = conj(E[k] - W^k O[k]).
+// emit(k, |X[k]|^2) is called once for every k < m, after X[k] is stored.
+template<typename Emit> void FFTPlan::recombine_(float *real, float *imag, Emit emit) const {
+  const size_t m = this->size_ / 2;
+  const float z0r = real[0], z0i = imag[0];
+  real[0] = z0r + z0i;
+  imag[0] = 0.0f;
+  real[m] = z0r - z0i;
+  imag[m] = 0.0f;
+  emit(0, real[0] * real[0]);
+  for (size_t k = 1; k <= m / 2; k++) {
+    const size_t j = m - k;
+    const float er = 0.5f * (real[k] + real[j]);
+    const float ei = 0.5f * (imag[k] - imag[j]);
+    const float orr = 0.5f * (imag[k] + imag[j]);
+    const float oi = -0.5f * (real[k] - real[j]);
+    // W_N^k lives in the last stage table, or on its own for other sizes
+    const size_t w = this->mixed_ != nullptr ? k : m - 1 + k;
+    const float wr = this->twiddle_re_[w];
+    const float wi = this->twiddle_im_[w];
+    const float tr = wr * orr - wi * oi;
+    const float ti = wr * oi + wi * orr;
+    real[k] = er + tr;
+    imag[k] = ei + ti;
+    real[j] = er - tr;
+    imag[j] = ti - ei;
+    emit(k, real[k] * real[k] + imag[k] * imag[k]);
+    if (j != k)
+      emit(j, real[j] * real[j] + imag[j] * imag[j]);
+  }
+}
+
+void FFTPlan::forward_real(const float *in, float *real, float *imag, bool windowed) const {
+  this->pack_and_transform_(in, real, imag, windowed);
+  this->recombine_(real, imag, [](size_t, float) {});
+}
+
+void FFTPlan::forward_spectrum(const float *in, float *real, float *imag, float *out,
+                               const SpectrumFormat &format) const {
+  this->pack_and_transform_(in, real, imag, true);
+  format.with_converter([this, real, imag, out](auto convert) {
+    this->recombine_(real, imag, [out, convert](size_t k, float power) { out[k] = convert(power); });
+  });
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
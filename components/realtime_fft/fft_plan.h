@@ -0,0 +1,98 @@
+#pragma once
+
+#include "fft_kernels.h"
+#include "memory_arena.h"
+#include "mixed_radix_fft.h"
+#include "spectrum_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Appends the (i, rev(i)) index pairs with i < rev(i) of an n-point bit reversal;
+// only the pairs that actually move are stored.
+void build_bit_reversal_swaps(size_t n, InternalVector<uint16_t> &swaps);
+
+// Precomputed tables for an FFT of one size.
+//
+// Built once per FFT size and shared by every frame: twiddle factors, the
+// bit-reversal swap list and the Hann window, so the per-frame path does no
+// trigonometry and no index arithmetic beyond table lookups. Data is kept in
+// split real/imaginary arrays and transformed with radix-4 passes through the
+// fastest kernel the CPU supports.
+//
+// Even sizes that aren't a power of two (960, 1000, ...) run their size/2
+// complex transform through MixedRadixFFT instead, so frames can match the
+// sample blocks of 48 kHz and 16 kHz sources without zero-padding. Those plans
+// hold scratch memory and must not be shared between tasks.
+class FFTPlan {
+ public:
+  explicit FFTPlan(size_t size);
+
+  // Powers of two between 2 and 65536.
+  static bool is_power_of_two_size(size_t size);
+  // Powers of two, and even sizes between 4 and 65536.
+  static bool is_supported_size(size_t size);
+
+  bool is_valid() const { return this->size_ != 0; }
+  bool is_power_of_two() const { return this->mixed_ == nullptr; }
+  size_t size() const { return this->size_; }
+  const float *window() const { return this->window_.data(); }
+  // Radix-4 kernel in use, or "mixed_radix"/"bluestein" for other sizes
+  const char *kernel_name() const {
+    return this->mixed_ != nullptr ? this->mixed_->name() : this->kernel_.name;
+  }
+
+  // Heap bytes held by the tables and scratch
+  size_t memory_bytes() const;
+
+  // Swap in a different radix-4 kernel, e.g. the scalar one for comparisons.
+  void set_kernel(Radix4Kernel kernel) { this->kernel_ = kernel; }
+
+  // out[i] = in[i] * window[i] for the full frame; in and out may alias.
+  void apply_window(const float *in, float *out) const;
+
+  // In-place forward transform on split real/imaginary arrays.
+  void forward(float *real, float *imag) const;
+
+  // Forward transform of size() real samples through a size()/2 complex FFT.
+  // real and imag receive bins 0..size()/2 inclusive (size()/2 + 1 entries each);
+  // with windowed set the Hann window is applied while packing the input.
+  // real may point at in: packing never writes ahead of what it has read, so a
+  // frame buffer can double as the real part once it is no longer needed.
+  void forward_real(const float *in, float *real, float *imag, bool windowed = false) const;
+
+  // forward_real() with the Hann window, also writing bins 0..size()/2 - 1 to
+  // out in the given format from inside the recombination loop, so there is no
+  // separate magnitude pass. out may alias imag, which then holds the output
+  // instead of the bins' imaginary parts.
+  void forward_spectrum(const float *in, float *real, float *imag, float *out, const SpectrumFormat &format) const;
+
+ protected:
+  void transform_(float *real, float *imag, size_t n, const InternalVector<uint16_t> &swaps) const;
+  void pack_and_transform_(const float *in, float *real, float *imag, bool windowed) const;
+  template<typename Emit> void recombine_(float *real, float *imag, Emit emit) const;
+  void forward_mixed_(float *real, float *imag) const;
+
+  size_t size_{0};
+  Radix4Kernel kernel_;
+  // Per-stage twiddles: the stage with half-length h stores exp(-pi*i*j/h) for
+  // j < h contiguously at offset h - 1, so kernels can load them as vectors.
+  // Tables and scratch are kept in internal RAM (see InternalAllocator).
+  InternalVector<float> twiddle_re_;
+  InternalVector<float> twiddle_im_;
+  // Flattened (i, rev(i)) pairs with i < rev(i), for N and for the N/2 real path.
+  InternalVector<uint16_t> swaps_;
+  InternalVector<uint16_t> half_swaps_;
+  InternalVector<float> window_;
+  // Other sizes: the size/2 complex transform, with W_N^k for k <= size/2 in
+  // twiddle_re_/twiddle_im_ and size/2 points of scratch for forward()
+  std::unique_ptr<MixedRadixFFT> mixed_;
+  mutable InternalVector<float> scratch_;
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
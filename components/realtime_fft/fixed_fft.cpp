@@ -0,0 +1,204 @@
+#include "fixed_fft.h"
+#include "fft_plan.h"
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Products are formed in a type twice as wide as the sample
+template<typename T> struct FixedAcc;
+template<> struct FixedAcc<int16_t> {
+  using type = int32_t;
+};
+template<> struct FixedAcc<int32_t> {
+  using type = int64_t;
+};
+
+template<typename T> static T to_fixed(double v) {
+  const double scale = std::ldexp(1.0, FixedFFT<T>::FRAC_BITS);
+  double q = std::round(v * scale);
+  if (q > scale - 1)
+    q = scale - 1;
+  if (q < -scale)
+    q = -scale;
+  return static_cast<T>(q);
+}
+
+template<typename T> static inline T mul_q(T a, T b) {
+  using Acc = typename FixedAcc<T>::type;
+  constexpr int frac = FixedFFT<T>::FRAC_BITS;
+  return static_cast<T>((static_cast<Acc>(a) * b + (Acc(1) << (frac - 1))) >> frac);
+}
+
+// Largest component magnitude in the block
+template<typename T> static typename FixedAcc<T>::type block_max(const T *real, const T *imag, size_t n) {
+  using Acc = typename FixedAcc<T>::type;
+  Acc max = 0;
+  for (size_t i = 0; i < n; i++) {
+    Acc r = std::abs(static_cast<Acc>(real[i]));
+    Acc q = std::abs(static_cast<Acc>(imag[i]));
+    if (r > max)
+      max = r;
+    if (q > max)
+      max = q;
+  }
+  return max;
+}
+
+template<typename T> static void shift_block(T *real, T *imag, size_t n, int shift) {
+  if (shift > 0) {
+    for (size_t i = 0; i < n; i++) {
+      real[i] = static_cast<T>(real[i] >> shift);
+      imag[i] = static_cast<T>(imag[i] >> shift);
+    }
+  } else if (shift < 0) {
+    for (size_t i = 0; i < n; i++) {
+      real[i] = static_cast<T>(real[i] * (T(1) << -shift));
+      imag[i] = static_cast<T>(imag[i] * (T(1) << -shift));
+    }
+  }
+}
+
+template<typename T> FixedFFT<T>::FixedFFT(size_t size) {
+  if (!FFTPlan::is_power_of_two_size(size) || size < 4)
+    return;
+  this->size_ = size;
+
+  const size_t half = size / 2;
+  this->twiddle_re_.resize(half);
+  this->twiddle_im_.resize(half);
+  for (size_t k = 0; k < half; k++) {
+    double theta = -2.0 * M_PI * k / size;
+    this->twiddle_re_[k] = to_fixed<T>(std::cos(theta));
+    this->twiddle_im_[k] = to_fixed<T>(std::sin(theta));
+  }
+  build_bit_reversal_swaps(half, this->half_swaps_);
+
+  // Hann window
+  this->window_.resize(size);
+  for (size_t i = 0; i < size; i++)
+    this->window_[i] = to_fixed<T>(0.5 * (1.0 - std::cos(2.0 * M_PI * i / (size - 1))));
+
+  this->real_.resize(half + 1);
+  this->imag_.resize(half + 1);
+}
+
+template<typename T> int FixedFFT<T>::forward_real(const T *in, T *real, T *imag) const {
+  using Acc = typename FixedAcc<T>::type;
+  const size_t n = this->size_;
+  const size_t m = n / 2;
+  // Keeping every component below a quarter of full scale before a stage leaves
+  // room for the (1 + sqrt(2)) worst-case growth of a radix-2 butterfly
+  const Acc limit = Acc(1) << (FRAC_BITS - 2);
+  int exponent = 0;
+
+  // Pack even samples into the real part and odd samples into the imaginary part
+  for (size_t i = 0; i < m; i++) {
+    real[i] = mul_q(in[2 * i], this->window_[2 * i]);
+    imag[i] = mul_q(in[2 * i + 1], this->window_[2 * i + 1]);
+  }
+
+  // Normalise the block into [limit / 2, limit)
+  Acc max = block_max(real, imag, m);
+  if (max == 0) {
+    for (size_t i = 0; i <= m; i++)
+      real[i] = imag[i] = 0;
+    return 0;
+  }
+  int shift = 0;
+  while (max >= limit) {
+    max >>= 1;
+    shift++;
+  }
+  while (max < limit / 2) {
+    max <<= 1;
+    shift--;
+  }
+  shift_block(real, imag, m, shift);
+  exponent += shift;
+
+  for (size_t s = 0; s < this->half_swaps_.size(); s += 2) {
+    size_t a = this->half_swaps_[s], b = this->half_swaps_[s + 1];
+    std::swap(real[a], real[b]);
+    std::swap(imag[a], imag[b]);
+  }
+
+  // Radix-2 stages; the output maximum is tracked on the fly to decide the next scaling
+  for (size_t h = 1, stride = n / 2; h < m; h *= 2, stride /= 2) {
+    if (max >= limit) {
+      shift_block(real, imag, m, 1);
+      exponent++;
+    }
+    max = 0;
+    for (size_t k = 0; k < m; k += 2 * h) {
+      for (size_t j = 0; j < h; j++) {
+        const Acc wr = this->twiddle_re_[j * stride];
+        const Acc wi = this->twiddle_im_[j * stride];
+        const size_t a = k + j, b = a + h;
+        const Acc round = Acc(1) << (FRAC_BITS - 1);
+        const Acc tr = (wr * real[b] - wi * imag[b] + round) >> FRAC_BITS;
+        const Acc ti = (wr * imag[b] + wi * real[b] + round) >> FRAC_BITS;
+        const Acc ar = real[a], ai = imag[a];
+        const Acc outs[4] = {ar + tr, ai + ti, ar - tr, ai - ti};
+        real[a] = static_cast<T>(outs[0]);
+        imag[a] = static_cast<T>(outs[1]);
+        real[b] = static_cast<T>(outs[2]);
+        imag[b] = static_cast<T>(outs[3]);
+        for (Acc v : outs) {
+          if (std::abs(v) > max)
+            max = std::abs(v);
+        }
+      }
+    }
+  }
+  if (max >= limit) {
+    shift_block(real, imag, m, 1);
+    exponent++;
+  }
+
+  // Split into even/odd spectra and recombine, as in FFTPlan::forward_real
+  const Acc z0r = real[0], z0i = imag[0];
+  real[0] = static_cast<T>(z0r + z0i);
+  imag[0] = 0;
+  real[m] = static_cast<T>(z0r - z0i);
+  imag[m] = 0;
+  for (size_t k = 1; k <= m / 2; k++) {
+    const size_t j = m - k;
+    const Acc er = (static_cast<Acc>(real[k]) + real[j]) >> 1;
+    const Acc ei = (static_cast<Acc>(imag[k]) - imag[j]) >> 1;
+    const Acc orr = (static_cast<Acc>(imag[k]) + imag[j]) >> 1;
+    const Acc oi = (static_cast<Acc>(real[j]) - real[k]) >> 1;
+    const Acc wr = this->twiddle_re_[k];
+    const Acc wi = this->twiddle_im_[k];
+    const Acc round = Acc(1) << (FRAC_BITS - 1);
+    const Acc tr = (wr * orr - wi * oi + round) >> FRAC_BITS;
+    const Acc ti = (wr * oi + wi * orr + round) >> FRAC_BITS;
+    real[k] = static_cast<T>(er + tr);
+    imag[k] = static_cast<T>(ei + ti);
+    real[j] = static_cast<T>(er - tr);
+    imag[j] = static_cast<T>(ti - ei);
+  }
+  return exponent;
+}
+
+template<typename T> void FixedFFT<T>::spectrum(const T *in, float *out, const SpectrumFormat &format) {
+  int exponent = this->forward_real(in, this->real_.data(), this->imag_.data());
+  // Power scales with the square of the block exponent
+  const float scale = std::ldexp(1.0f, 2 * (exponent - FRAC_BITS));
+  const T *real = this->real_.data(), *imag = this->imag_.data();
+  const size_t count = this->size_ / 2;
+  format.with_converter([real, imag, out, count, scale](auto convert) {
+    for (size_t k = 0; k < count; k++) {
+      const float r = real[k], i = imag[k];
+      out[k] = convert((r * r + i * i) * scale);
+    }
+  });
+}
+
+template class FixedFFT<int16_t>;
+template class FixedFFT<int32_t>;
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "memory_arena.h"
+#include "spectrum_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Fixed-point real-input FFT for integer I2S samples (Q15 for int16_t, Q31 for int32_t).
+//
+// Uses the same N/2 complex packing as FFTPlan::forward_real, but keeps data,
+// twiddles and the Hann window in the sample format. Block floating-point
+// scaling tracks one shared exponent per frame: the block is normalised up front
+// and halved before any stage that could overflow, so quiet and loud input both
+// keep full precision without floating-point arithmetic in the butterflies.
+template<typename T> class FixedFFT {
+ public:
+  explicit FixedFFT(size_t size);
+
+  bool is_valid() const { return this->size_ != 0; }
+  size_t size() const { return this->size_; }
+  // Heap bytes held by the tables and scratch
+  size_t memory_bytes() const {
+    return (this->twiddle_re_.size() + this->twiddle_im_.size() + this->window_.size() + this->real_.size() +
+            this->imag_.size()) *
+               sizeof(T) +
+           this->half_swaps_.size() * sizeof(uint16_t);
+  }
+
+  // Windows and transforms size() samples. real and imag receive bins
+  // 0..size()/2 inclusive; the true value of a bin is stored * 2^(exponent - FRAC_BITS)
+  // with a full-scale sample counting as 1.0. Returns the block exponent.
+  int forward_real(const T *in, T *real, T *imag) const;
+
+  // Transforms one frame into size()/2 float bins in the given format, using
+  // internal scratch. The recombination stays in integers; scaling and the
+  // format conversion share the one pass out to float.
+  void spectrum(const T *in, float *out, const SpectrumFormat &format);
+  // Same, as magnitudes.
+  void magnitudes(const T *in, float *out) { this->spectrum(in, out, SpectrumFormat()); }
+
+  static constexpr int FRAC_BITS = sizeof(T) * 8 - 1;
+
+ protected:
+  size_t size_{0};
+  // exp(-2*pi*i*k/N) for k < N/2; the stage with half-length h reads every N/(2h)-th entry
+  InternalVector<T> twiddle_re_;
+  InternalVector<T> twiddle_im_;
+  InternalVector<uint16_t> half_swaps_;
+  InternalVector<T> window_;
+  InternalVector<T> real_;
+  InternalVector<T> imag_;
+};
+
+extern template class FixedFFT<int16_t>;
+extern template class FixedFFT<int32_t>;
+
+}  // namespace realtime_fft
+}  // namespace esphome
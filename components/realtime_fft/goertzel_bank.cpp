@@ -0,0 +1,113 @@
+#include "goertzel_bank.h"
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace realtime_fft {
+
+template<typename T> static constexpr float full_scale() { return 1.0f; }
+template<> constexpr float full_scale<int16_t>() { return 1.0f / 32768.0f; }
+template<> constexpr float full_scale<int32_t>() { return 1.0f / 2147483648.0f; }
+
+GoertzelBank::GoertzelBank(int sample_rate, size_t block_size, size_t hop_size, const std::vector<float> &frequencies) {
+  if (sample_rate <= 0 || block_size < 2 || hop_size == 0 || hop_size > block_size || frequencies.empty())
+    return;
+  this->block_size_ = block_size;
+  this->hop_size_ = hop_size;
+
+  for (float frequency : frequencies)
+    this->coefficients_.push_back(static_cast<float>(2.0 * std::cos(2.0 * M_PI * frequency / sample_rate)));
+  const double step = 2.0 * M_PI / (block_size - 1);
+  this->rotate_cos_ = static_cast<float>(std::cos(step));
+  this->rotate_sin_ = static_cast<float>(std::sin(step));
+
+  // A new block starts every hop, and each runs for block_size samples
+  const size_t sets = (block_size + hop_size - 1) / hop_size;
+  this->accumulators_.resize(sets);
+  this->s1_.resize(sets * frequencies.size());
+  this->s2_.resize(sets * frequencies.size());
+  this->powers_.resize(frequencies.size());
+  this->reset();
+}
+
+// Operation counts per frame of n samples. Goertzel: one multiply and two adds
+// per filter and sample, plus the window phasor. FFT: about 2.5 n log2(n/2)
+// for the n/2-point complex transform behind the real one, plus windowing,
+// the recombination and the power spectrum, counted as 5 n.
+bool GoertzelBank::is_cheaper_than_fft(size_t count, size_t block_size) {
+  const double n = static_cast<double>(block_size);
+  const double goertzel = n * (3.0 * count + 6.0);
+  const double fft = 2.5 * n * std::log2(std::max(n / 2.0, 2.0)) + 5.0 * n;
+  return goertzel < fft;
+}
+
+void GoertzelBank::reset() {
+  for (Accumulator &a : this->accumulators_)
+    a.remaining = 0;
+  this->until_start_ = 0;
+  this->next_start_ = 0;
+}
+
+void GoertzelBank::start_(size_t index) {
+  Accumulator &a = this->accumulators_[index];
+  a.remaining = this->block_size_;
+  a.cos = 1.0f;
+  a.sin = 0.0f;
+  const size_t count = this->size();
+  std::fill_n(this->s1_.begin() + index * count, count, 0.0f);
+  std::fill_n(this->s2_.begin() + index * count, count, 0.0f);
+}
+
+void GoertzelBank::step_(float sample, const BlockCallback &callback, size_t &blocks) {
+  if (this->until_start_ == 0) {
+    this->start_(this->next_start_);
+    this->next_start_ = (this->next_start_ + 1) % this->accumulators_.size();
+    this->until_start_ = this->hop_size_;
+  }
+  this->until_start_--;
+
+  const size_t count = this->size();
+  const float *coefficients = this->coefficients_.data();
+  for (size_t i = 0; i < this->accumulators_.size(); i++) {
+    Accumulator &a = this->accumulators_[i];
+    if (a.remaining == 0)
+      continue;
+    const float x = sample * (0.5f - 0.5f * a.cos);
+    const float c = a.cos * this->rotate_cos_ - a.sin * this->rotate_sin_;
+    a.sin = a.sin * this->rotate_cos_ + a.cos * this->rotate_sin_;
+    a.cos = c;
+
+    float *s1 = this->s1_.data() + i * count;
+    float *s2 = this->s2_.data() + i * count;
+    for (size_t f = 0; f < count; f++) {
+      const float s0 = x + coefficients[f] * s1[f] - s2[f];
+      s2[f] = s1[f];
+      s1[f] = s0;
+    }
+
+    if (--a.remaining == 0) {
+      // |X(w)|^2 = s1^2 + s2^2 - 2 cos(w) s1 s2 after the last sample
+      for (size_t f = 0; f < count; f++) {
+        const float power = s1[f] * s1[f] + s2[f] * s2[f] - coefficients[f] * s1[f] * s2[f];
+        this->powers_[f] = std::max(power, 0.0f);
+      }
+      callback(this->powers_.data());
+      blocks++;
+    }
+  }
+}
+
+template<typename T>
+size_t GoertzelBank::push(const T *samples, size_t count, size_t stride, const BlockCallback &callback) {
+  size_t blocks = 0;
+  for (size_t i = 0; i < count; i += stride)
+    this->step_(samples[i] * full_scale<T>(), callback, blocks);
+  return blocks;
+}
+
+template size_t GoertzelBank::push<float>(const float *, size_t, size_t, const BlockCallback &);
+template size_t GoertzelBank::push<int16_t>(const int16_t *, size_t, size_t, const BlockCallback &);
+template size_t GoertzelBank::push<int32_t>(const int32_t *, size_t, size_t, const BlockCallback &);
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Streaming Goertzel filters for a handful of target frequencies.
+//
+// Each sample updates every filter as it arrives, so there is no frame buffer
+// and no transform: after block_size samples the filters hold the DFT
+// powers at exactly the target frequencies (not rounded to a bin) and are
+// restarted. The Hann window is generated per sample by a rotating phasor
+// instead of a table, and powers use the same scale as FFTPlan's windowed
+// real transform, so the two engines can stand in for each other.
+//
+// With hop_size < block_size, overlapping blocks are run by staggered sets of
+// filters, one started every hop_size samples, exactly like the STFT framer's
+// frames.
+class GoertzelBank {
+ public:
+  // Called with one squared magnitude per frequency, in the order given.
+  using BlockCallback = std::function<void(const float *powers)>;
+
+  GoertzelBank(int sample_rate, size_t block_size, size_t hop_size, const std::vector<float> &frequencies);
+
+  // Rough operation counts per frame: whether count Goertzel filters over
+  // block_size samples beat a real FFT of the same size plus its magnitudes.
+  static bool is_cheaper_than_fft(size_t count, size_t block_size);
+
+  bool is_valid() const { return this->block_size_ != 0; }
+  size_t size() const { return this->coefficients_.size(); }
+  size_t block_size() const { return this->block_size_; }
+
+  // Feeds count samples, taking every stride-th one (channel 0 of interleaved
+  // input), and invokes the callback per completed block. Integer samples are
+  // scaled so that full scale is 1.0, as in the FFT paths. Returns the number
+  // of blocks completed.
+  template<typename T> size_t push(const T *samples, size_t count, size_t stride, const BlockCallback &callback);
+
+  // Drops all partial blocks; the next block needs block_size new samples.
+  void reset();
+
+ protected:
+  // One set of filters running over one block
+  struct Accumulator {
+    // Samples still to go, 0 when idle
+    size_t remaining;
+    // Window phasor: cos and sin of 2 pi n / (block_size - 1)
+    float cos;
+    float sin;
+  };
+
+  void start_(size_t index);
+  void step_(float sample, const BlockCallback &callback, size_t &blocks);
+
+  size_t block_size_{0};
+  size_t hop_size_{0};
+  // 2 cos(2 pi f / fs) per frequency
+  std::vector<float> coefficients_;
+  // Phasor rotation per sample
+  float rotate_cos_{1.0f};
+  float rotate_sin_{0.0f};
+  std::vector<Accumulator> accumulators_;
+  // s[n-1] and s[n-2] of every filter, one row of size() per accumulator
+  std::vector<float> s1_;
+  std::vector<float> s2_;
+  std::vector<float> powers_;
+  size_t until_start_{0};
+  size_t next_start_{0};
+};
+
+extern template size_t GoertzelBank::push<float>(const float *, size_t, size_t, const BlockCallback &);
+extern template size_t GoertzelBank::push<int16_t>(const int16_t *, size_t, size_t, const BlockCallback &);
+extern template size_t GoertzelBank::push<int32_t>(const int32_t *, size_t, size_t, const BlockCallback &);
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,134 @@
+#include "memory_arena.h"
+#include <new>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+namespace esphome {
+namespace realtime_fft {
+
+static size_t align_up(size_t bytes) { return (bytes + MemoryArena::ALIGNMENT - 1) & ~(MemoryArena::ALIGNMENT - 1); }
+
+MemoryArena::~MemoryArena() {
+  free_region(this->base_[MEMORY_INTERNAL]);
+  free_region(this->base_[MEMORY_EXTERNAL]);
+}
+
+int MemoryArena::add(const char *name, size_t bytes, MemoryRegion region) {
+  this->blocks_.push_back({name, bytes, region, -1, 0});
+  return this->blocks_.size() - 1;
+}
+
+int MemoryArena::alias(const char *name, int with, size_t bytes) {
+  // Always point at the block that owns the storage, so chains don't form
+  while (this->blocks_[with].owner >= 0)
+    with = this->blocks_[with].owner;
+  this->blocks_.push_back({name, bytes, this->blocks_[with].region, with, 0});
+  return this->blocks_.size() - 1;
+}
+
+bool MemoryArena::allocate(bool use_external) {
+  if (!use_external) {
+    for (Block &block : this->blocks_)
+      block.region = MEMORY_INTERNAL;
+  }
+
+  // Owners get consecutive aligned slots sized for their largest alias
+  std::vector<size_t> sizes(this->blocks_.size(), 0);
+  for (size_t i = 0; i < this->blocks_.size(); i++) {
+    const Block &block = this->blocks_[i];
+    const size_t owner = block.owner >= 0 ? block.owner : i;
+    if (block.bytes > sizes[owner])
+      sizes[owner] = block.bytes;
+  }
+  size_t totals[2]{0, 0};
+  for (size_t i = 0; i < this->blocks_.size(); i++) {
+    Block &block = this->blocks_[i];
+    if (block.owner < 0) {
+      block.offset = totals[block.region];
+      totals[block.region] += align_up(sizes[i]);
+    }
+  }
+
+  if (totals[MEMORY_EXTERNAL] > 0) {
+    this->base_[MEMORY_EXTERNAL] = allocate_region(totals[MEMORY_EXTERNAL], MEMORY_EXTERNAL);
+    if (this->base_[MEMORY_EXTERNAL] == nullptr) {
+      // No PSRAM after all: lay the external blocks out after the internal ones
+      for (size_t i = 0; i < this->blocks_.size(); i++) {
+        Block &block = this->blocks_[i];
+        if (block.owner < 0 && block.region == MEMORY_EXTERNAL) {
+          block.region = MEMORY_INTERNAL;
+          block.offset += totals[MEMORY_INTERNAL];
+        }
+      }
+      totals[MEMORY_INTERNAL] += totals[MEMORY_EXTERNAL];
+      totals[MEMORY_EXTERNAL] = 0;
+    }
+  }
+  if (totals[MEMORY_INTERNAL] > 0) {
+    this->base_[MEMORY_INTERNAL] = allocate_region(totals[MEMORY_INTERNAL], MEMORY_INTERNAL);
+    if (this->base_[MEMORY_INTERNAL] == nullptr)
+      return false;
+  }
+  for (Block &block : this->blocks_) {
+    if (block.owner >= 0) {
+      block.region = this->blocks_[block.owner].region;
+      block.offset = this->blocks_[block.owner].offset;
+    }
+  }
+  this->region_bytes_[MEMORY_INTERNAL] = totals[MEMORY_INTERNAL];
+  this->region_bytes_[MEMORY_EXTERNAL] = totals[MEMORY_EXTERNAL];
+  return true;
+}
+
+size_t MemoryArena::aliased_bytes() const {
+  size_t requested = 0;
+  for (const Block &block : this->blocks_)
+    requested += align_up(block.bytes);
+  return requested - this->region_bytes_[MEMORY_INTERNAL] - this->region_bytes_[MEMORY_EXTERNAL];
+}
+
+uint8_t *MemoryArena::allocate_region(size_t bytes, MemoryRegion region) {
+#ifdef ESP_PLATFORM
+  const uint32_t caps = region == MEMORY_EXTERNAL ? MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT
+                                                  : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+  return static_cast<uint8_t *>(heap_caps_aligned_alloc(ALIGNMENT, bytes, caps));
+#else
+  // Hosts have no PSRAM, which takes the internal fallback above
+  if (region == MEMORY_EXTERNAL)
+    return nullptr;
+  return static_cast<uint8_t *>(::operator new(bytes, std::align_val_t(ALIGNMENT), std::nothrow));
+#endif
+}
+
+void *allocate_internal(size_t bytes) {
+#ifdef ESP_PLATFORM
+  void *p = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  // Slow tables beat none: with internal RAM full, take whatever is left
+  return p != nullptr ? p : heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+#else
+  return ::operator new(bytes);
+#endif
+}
+
+void free_internal(void *p) {
+#ifdef ESP_PLATFORM
+  heap_caps_free(p);
+#else
+  ::operator delete(p);
+#endif
+}
+
+void MemoryArena::free_region(uint8_t *base) {
+  if (base == nullptr)
+    return;
+#ifdef ESP_PLATFORM
+  heap_caps_free(base);
+#else
+  ::operator delete(base, std::align_val_t(ALIGNMENT));
+#endif
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Where an arena block should live
+enum MemoryRegion : uint8_t {
+  // On-chip RAM: tables and work buffers touched in the transform's inner loops
+  MEMORY_INTERNAL = 0,
+  // PSRAM when present: large buffers only streamed through once per hop
+  MEMORY_EXTERNAL,
+};
+
+// One allocation per memory region for all of a pipeline's working buffers.
+//
+// The layout is declared first, with add() for every buffer and alias() for
+// buffers whose lifetimes don't overlap with one already added, which then
+// share its storage. allocate() then makes a single aligned allocation per
+// region, so the whole footprint is known up front, the heap isn't
+// fragmented by a dozen small blocks, and everything is released together.
+//
+// External blocks go to PSRAM on ESP32 targets that have it; elsewhere, or
+// when PSRAM is disabled or full, they fall back to internal RAM.
+class MemoryArena {
+ public:
+  // Every block starts on this boundary, enough for 128-bit loads
+  static constexpr size_t ALIGNMENT = 16;
+
+  MemoryArena() = default;
+  MemoryArena(const MemoryArena &) = delete;
+  MemoryArena &operator=(const MemoryArena &) = delete;
+  ~MemoryArena();
+
+  // Declares a block and returns its handle; only valid before allocate()
+  int add(const char *name, size_t bytes, MemoryRegion region);
+  // Declares a block sharing the storage of block `with`, which grows to fit
+  int alias(const char *name, int with, size_t bytes);
+
+  // Allocates every region; use_external = false keeps everything internal.
+  // Returns false if some region could not be allocated at all.
+  bool allocate(bool use_external);
+
+  template<typename T> T *get(int block) const {
+    return reinterpret_cast<T *>(this->base_[this->blocks_[block].region] + this->blocks_[block].offset);
+  }
+
+  // Bytes allocated in a region, and bytes saved by aliasing
+  size_t bytes(MemoryRegion region) const { return this->region_bytes_[region]; }
+  size_t aliased_bytes() const;
+  // Whether external blocks actually landed in PSRAM
+  bool is_external() const { return this->base_[MEMORY_EXTERNAL] != nullptr; }
+
+  size_t block_count() const { return this->blocks_.size(); }
+  const char *block_name(int block) const { return this->blocks_[block].name; }
+  size_t block_bytes(int block) const { return this->blocks_[block].bytes; }
+  // Handle of the block whose storage this one shares, or -1
+  int block_owner(int block) const { return this->blocks_[block].owner; }
+  MemoryRegion block_region(int block) const { return this->blocks_[block].region; }
+
+ protected:
+  struct Block {
+    const char *name;
+    size_t bytes;
+    MemoryRegion region;
+    int owner;
+    size_t offset;
+  };
+
+  static uint8_t *allocate_region(size_t bytes, MemoryRegion region);
+  static void free_region(uint8_t *base);
+
+  std::vector<Block> blocks_;
+  uint8_t *base_[2]{nullptr, nullptr};
+  size_t region_bytes_[2]{0, 0};
+};
+
+// Heap memory that stays in on-chip RAM even with CONFIG_SPIRAM_USE_MALLOC,
+// which would otherwise let plain allocations land in PSRAM. Falls back to
+// any memory once internal RAM is exhausted.
+void *allocate_internal(size_t bytes);
+void free_internal(void *p);
+
+// Allocator for the lookup tables that every transform reads in its inner
+// loops (twiddles, windows, bit-reversal swaps), which a PSRAM cache miss
+// per access would slow down several times over.
+template<typename T> class InternalAllocator {
+ public:
+  using value_type = T;
+
+  InternalAllocator() = default;
+  template<typename U> InternalAllocator(const InternalAllocator<U> &) {}
+
+  T *allocate(size_t n) { return static_cast<T *>(allocate_internal(n * sizeof(T))); }
+  void deallocate(T *p, size_t) { free_internal(p); }
+
+  template<typename U> bool operator==(const InternalAllocator<U> &) const { return true; }
+  template<typename U> bool operator!=(const InternalAllocator<U> &) const { return false; }
+};
+
+template<typename T> using InternalVector = std::vector<T, InternalAllocator<T>>;
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,263 @@
+#include "mixed_radix_fft.h"
+#include "fft_plan.h"
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace realtime_fft {
+
+bool MixedRadixFFT::is_smooth(size_t size) {
+  if (size == 0)
+    return false;
+  for (size_t p : {2, 3, 5}) {
+    while (size % p == 0)
+      size /= p;
+  }
+  return size == 1;
+}
+
+MixedRadixFFT::MixedRadixFFT(size_t size) {
+  if (size < 2 || size > 32768)
+    return;
+  this->size_ = size;
+
+  if (is_smooth(size)) {
+    // Radix 4 first, as it needs the fewest multiplies per point
+    size_t n = size;
+    for (size_t p : {4, 2, 3, 5}) {
+      while (n % p == 0) {
+        n /= p;
+        this->factors_.push_back(p);
+        this->factors_.push_back(n);
+      }
+    }
+    this->twiddle_re_.resize(size);
+    this->twiddle_im_.resize(size);
+    for (size_t k = 0; k < size; k++) {
+      const double theta = -2.0 * M_PI * k / size;
+      this->twiddle_re_[k] = static_cast<float>(std::cos(theta));
+      this->twiddle_im_[k] = static_cast<float>(std::sin(theta));
+    }
+    this->scratch_re_.resize(size);
+    this->scratch_im_.resize(size);
+    return;
+  }
+
+  // Bluestein: X[k] = c[k] * sum_j (x[j] c[j]) conj(c[k - j]) with c[k] = exp(-pi i k^2 / n),
+  // a linear convolution of length 2n - 1 done as a circular one of size m
+  size_t m = 1;
+  while (m < 2 * size - 1)
+    m *= 2;
+  this->conv_.reset(new FFTPlan(m));
+  this->chirp_re_.resize(size);
+  this->chirp_im_.resize(size);
+  this->kernel_re_.assign(m, 0.0f);
+  this->kernel_im_.assign(m, 0.0f);
+  for (size_t k = 0; k < size; k++) {
+    // k^2 mod 2n keeps the angle small, so large k lose no precision
+    const double theta = -M_PI * static_cast<double>((k * k) % (2 * size)) / size;
+    this->chirp_re_[k] = static_cast<float>(std::cos(theta));
+    this->chirp_im_[k] = static_cast<float>(std::sin(theta));
+    this->kernel_re_[k] = this->chirp_re_[k];
+    this->kernel_im_[k] = -this->chirp_im_[k];
+    if (k > 0) {
+      this->kernel_re_[m - k] = this->kernel_re_[k];
+      this->kernel_im_[m - k] = this->kernel_im_[k];
+    }
+  }
+  this->conv_->forward(this->kernel_re_.data(), this->kernel_im_.data());
+  // The inverse transform is unnormalised, fold its 1/m in here
+  for (size_t k = 0; k < m; k++) {
+    this->kernel_re_[k] /= m;
+    this->kernel_im_[k] /= m;
+  }
+  this->scratch_re_.resize(m);
+  this->scratch_im_.resize(m);
+}
+
+MixedRadixFFT::~MixedRadixFFT() = default;
+
+size_t MixedRadixFFT::memory_bytes() const {
+  size_t bytes = this->factors_.size() * sizeof(uint32_t) +
+                 (this->twiddle_re_.size() + this->twiddle_im_.size() + this->scratch_re_.size() +
+                  this->scratch_im_.size() + this->chirp_re_.size() + this->chirp_im_.size() +
+                  this->kernel_re_.size() + this->kernel_im_.size()) *
+                     sizeof(float);
+  if (this->conv_ != nullptr)
+    bytes += this->conv_->memory_bytes();
+  return bytes;
+}
+
+void MixedRadixFFT::forward(float *real, float *imag) {
+  if (this->conv_ != nullptr) {
+    this->bluestein_(real, imag);
+    return;
+  }
+  std::copy_n(real, this->size_, this->scratch_re_.data());
+  std::copy_n(imag, this->size_, this->scratch_im_.data());
+  this->work_(real, imag, this->scratch_re_.data(), this->scratch_im_.data(), 1, this->factors_.data());
+}
+
+// Decimation in time: splits the input (read every stride points) into p
+// interleaved sub-sequences of length m, transforms each into consecutive
+// blocks of out, then combines the blocks with radix-p butterflies.
+void MixedRadixFFT::work_(float *out_re, float *out_im, const float *in_re, const float *in_im, size_t stride,
+                          const uint32_t *factors) const {
+  const size_t p = factors[0], m = factors[1];
+  if (m == 1) {
+    for (size_t i = 0; i < p; i++) {
+      out_re[i] = in_re[i * stride];
+      out_im[i] = in_im[i * stride];
+    }
+  } else {
+    for (size_t i = 0; i < p; i++)
+      this->work_(out_re + i * m, out_im + i * m, in_re + i * stride, in_im + i * stride, stride * p, factors + 2);
+  }
+
+  switch (p) {
+    case 2:
+      this->butterfly2_(out_re, out_im, stride, m);
+      break;
+    case 3:
+      this->butterfly3_(out_re, out_im, stride, m);
+      break;
+    case 4:
+      this->butterfly4_(out_re, out_im, stride, m);
+      break;
+    default:
+      this->butterfly5_(out_re, out_im, stride, m);
+      break;
+  }
+}
+
+// In the butterflies, block q holds the m-point transform of sub-sequence q and
+// the twiddle for point k of block q is W_n^(q k stride).
+
+void MixedRadixFFT::butterfly2_(float *re, float *im, size_t stride, size_t m) const {
+  const float *wr = this->twiddle_re_.data(), *wi = this->twiddle_im_.data();
+  for (size_t k = 0; k < m; k++) {
+    const size_t t = k * stride;
+    const float tr = re[k + m] * wr[t] - im[k + m] * wi[t];
+    const float ti = re[k + m] * wi[t] + im[k + m] * wr[t];
+    re[k + m] = re[k] - tr;
+    im[k + m] = im[k] - ti;
+    re[k] += tr;
+    im[k] += ti;
+  }
+}
+
+void MixedRadixFFT::butterfly3_(float *re, float *im, size_t stride, size_t m) const {
+  const float *wr = this->twiddle_re_.data(), *wi = this->twiddle_im_.data();
+  // Imaginary part of W_3 = exp(-2 pi i / 3)
+  const float sin3 = wi[stride * m];
+  for (size_t k = 0; k < m; k++) {
+    const size_t t1 = k * stride, t2 = 2 * k * stride;
+    const float s1r = re[k + m] * wr[t1] - im[k + m] * wi[t1];
+    const float s1i = re[k + m] * wi[t1] + im[k + m] * wr[t1];
+    const float s2r = re[k + 2 * m] * wr[t2] - im[k + 2 * m] * wi[t2];
+    const float s2i = re[k + 2 * m] * wi[t2] + im[k + 2 * m] * wr[t2];
+    const float s3r = s1r + s2r, s3i = s1i + s2i;
+    const float s0r = (s1r - s2r) * sin3, s0i = (s1i - s2i) * sin3;
+    const float hr = re[k] - 0.5f * s3r, hi = im[k] - 0.5f * s3i;
+    re[k] += s3r;
+    im[k] += s3i;
+    re[k + m] = hr - s0i;
+    im[k + m] = hi + s0r;
+    re[k + 2 * m] = hr + s0i;
+    im[k + 2 * m] = hi - s0r;
+  }
+}
+
+void MixedRadixFFT::butterfly4_(float *re, float *im, size_t stride, size_t m) const {
+  const float *wr = this->twiddle_re_.data(), *wi = this->twiddle_im_.data();
+  for (size_t k = 0; k < m; k++) {
+    const size_t t1 = k * stride, t2 = 2 * k * stride, t3 = 3 * k * stride;
+    const float s0r = re[k + m] * wr[t1] - im[k + m] * wi[t1];
+    const float s0i = re[k + m] * wi[t1] + im[k + m] * wr[t1];
+    const float s1r = re[k + 2 * m] * wr[t2] - im[k + 2 * m] * wi[t2];
+    const float s1i = re[k + 2 * m] * wi[t2] + im[k + 2 * m] * wr[t2];
+    const float s2r = re[k + 3 * m] * wr[t3] - im[k + 3 * m] * wi[t3];
+    const float s2i = re[k + 3 * m] * wi[t3] + im[k + 3 * m] * wr[t3];
+    const float s5r = re[k] - s1r, s5i = im[k] - s1i;
+    const float ar = re[k] + s1r, ai = im[k] + s1i;
+    const float s3r = s0r + s2r, s3i = s0i + s2i;
+    const float s4r = s0r - s2r, s4i = s0i - s2i;
+    re[k] = ar + s3r;
+    im[k] = ai + s3i;
+    re[k + 2 * m] = ar - s3r;
+    im[k + 2 * m] = ai - s3i;
+    re[k + m] = s5r + s4i;
+    im[k + m] = s5i - s4r;
+    re[k + 3 * m] = s5r - s4i;
+    im[k + 3 * m] = s5i + s4r;
+  }
+}
+
+void MixedRadixFFT::butterfly5_(float *re, float *im, size_t stride, size_t m) const {
+  const float *wr = this->twiddle_re_.data(), *wi = this->twiddle_im_.data();
+  // W_5 and W_5^2
+  const float yar = wr[stride * m], yai = wi[stride * m];
+  const float ybr = wr[2 * stride * m], ybi = wi[2 * stride * m];
+  for (size_t k = 0; k < m; k++) {
+    float sr[5], si[5];
+    sr[0] = re[k];
+    si[0] = im[k];
+    for (size_t q = 1; q < 5; q++) {
+      const size_t t = q * k * stride;
+      sr[q] = re[k + q * m] * wr[t] - im[k + q * m] * wi[t];
+      si[q] = re[k + q * m] * wi[t] + im[k + q * m] * wr[t];
+    }
+    const float s7r = sr[1] + sr[4], s7i = si[1] + si[4];
+    const float s10r = sr[1] - sr[4], s10i = si[1] - si[4];
+    const float s8r = sr[2] + sr[3], s8i = si[2] + si[3];
+    const float s9r = sr[2] - sr[3], s9i = si[2] - si[3];
+
+    re[k] = sr[0] + s7r + s8r;
+    im[k] = si[0] + s7i + s8i;
+
+    const float s5r = sr[0] + s7r * yar + s8r * ybr, s5i = si[0] + s7i * yar + s8i * ybr;
+    const float s6r = s10i * yai + s9i * ybi, s6i = -s10r * yai - s9r * ybi;
+    re[k + m] = s5r - s6r;
+    im[k + m] = s5i - s6i;
+    re[k + 4 * m] = s5r + s6r;
+    im[k + 4 * m] = s5i + s6i;
+
+    const float s11r = sr[0] + s7r * ybr + s8r * yar, s11i = si[0] + s7i * ybr + s8i * yar;
+    const float s12r = -s10i * ybi + s9i * yai, s12i = s10r * ybi - s9r * yai;
+    re[k + 2 * m] = s11r + s12r;
+    im[k + 2 * m] = s11i + s12i;
+    re[k + 3 * m] = s11r - s12r;
+    im[k + 3 * m] = s11i - s12i;
+  }
+}
+
+void MixedRadixFFT::bluestein_(float *real, float *imag) {
+  const size_t n = this->size_;
+  const size_t m = this->scratch_re_.size();
+  float *ar = this->scratch_re_.data(), *ai = this->scratch_im_.data();
+  const float *cr = this->chirp_re_.data(), *ci = this->chirp_im_.data();
+  for (size_t k = 0; k < n; k++) {
+    ar[k] = real[k] * cr[k] - imag[k] * ci[k];
+    ai[k] = real[k] * ci[k] + imag[k] * cr[k];
+  }
+  std::fill(ar + n, ar + m, 0.0f);
+  std::fill(ai + n, ai + m, 0.0f);
+
+  this->conv_->forward(ar, ai);
+  const float *kr = this->kernel_re_.data(), *ki = this->kernel_im_.data();
+  for (size_t k = 0; k < m; k++) {
+    const float tr = ar[k] * kr[k] - ai[k] * ki[k];
+    ai[k] = ar[k] * ki[k] + ai[k] * kr[k];
+    ar[k] = tr;
+  }
+  // Inverse transform as a forward one with real and imaginary parts swapped
+  this->conv_->forward(ai, ar);
+
+  for (size_t k = 0; k < n; k++) {
+    real[k] = ar[k] * cr[k] - ai[k] * ci[k];
+    imag[k] = ar[k] * ci[k] + ai[k] * cr[k];
+  }
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "memory_arena.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+class FFTPlan;
+
+// Complex forward FFT of any length, for sizes that aren't a power of two.
+//
+// Lengths made of the factors 2, 3 and 5 (160, 480, 960, 1000, ...) run as a
+// mixed-radix decimation in time with radix-4, 2, 3 and 5 butterflies over one
+// table of n twiddles. Any other length, i.e. one with a prime factor above 5,
+// goes through Bluestein's algorithm: the DFT is rewritten as a circular
+// convolution with a chirp and evaluated with power-of-two FFTs of size
+// m >= 2n - 1, so a prime length costs a few m-point transforms rather than
+// n^2 operations.
+//
+// Data is in split real/imaginary arrays like FFTPlan. The transform uses
+// internal scratch, so one instance must not be shared between tasks.
+class MixedRadixFFT {
+ public:
+  explicit MixedRadixFFT(size_t size);
+  ~MixedRadixFFT();
+
+  // True when size only has the factors 2, 3 and 5
+  static bool is_smooth(size_t size);
+
+  bool is_valid() const { return this->size_ != 0; }
+  size_t size() const { return this->size_; }
+  bool is_bluestein() const { return this->conv_ != nullptr; }
+  const char *name() const { return this->is_bluestein() ? "bluestein" : "mixed_radix"; }
+  // Heap bytes held by the tables, scratch and convolution plan
+  size_t memory_bytes() const;
+
+  // In-place forward transform of size() points.
+  void forward(float *real, float *imag);
+
+ protected:
+  void work_(float *out_re, float *out_im, const float *in_re, const float *in_im, size_t stride,
+             const uint32_t *factors) const;
+  void butterfly2_(float *re, float *im, size_t stride, size_t m) const;
+  void butterfly3_(float *re, float *im, size_t stride, size_t m) const;
+  void butterfly4_(float *re, float *im, size_t stride, size_t m) const;
+  void butterfly5_(float *re, float *im, size_t stride, size_t m) const;
+  void bluestein_(float *real, float *imag);
+
+  size_t size_{0};
+  // (radix, remaining length) pairs, outermost stage first
+  std::vector<uint32_t> factors_;
+  // exp(-2 pi i k / n) for k < n
+  InternalVector<float> twiddle_re_;
+  InternalVector<float> twiddle_im_;
+  InternalVector<float> scratch_re_;
+  InternalVector<float> scratch_im_;
+
+  // Bluestein: chirp exp(-pi i k^2 / n), and the transform of its conjugate
+  // padded to the convolution size, pre-scaled by 1/m
+  std::unique_ptr<FFTPlan> conv_;
+  InternalVector<float> chirp_re_;
+  InternalVector<float> chirp_im_;
+  InternalVector<float> kernel_re_;
+  InternalVector<float> kernel_im_;
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,85 @@
+#include "multi_channel_fft.h"
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace realtime_fft {
+
+MultiChannelFFT::MultiChannelFFT(size_t size, size_t channels) : plan_(size) {
+  if (!this->plan_.is_valid() || channels == 0)
+    return;
+  this->channels_ = channels;
+  this->stride_ = size / 2 + 1;
+  this->real_.resize(channels * this->stride_);
+  this->imag_.resize(channels * this->stride_);
+}
+
+void MultiChannelFFT::forward(const float *frames) {
+  const size_t n = this->size();
+  size_t c = 0;
+  for (; c + 1 < this->channels_; c += 2) {
+    this->forward_pair_(frames + c * n, frames + (c + 1) * n, this->real_.data() + c * this->stride_,
+                        this->imag_.data() + c * this->stride_, nullptr, [](float power) { return power; });
+  }
+  if (c < this->channels_) {
+    this->plan_.forward_real(frames + c * n, this->real_.data() + c * this->stride_,
+                             this->imag_.data() + c * this->stride_, true);
+  }
+}
+
+void MultiChannelFFT::spectrum(const float *frames, float *out, const SpectrumFormat &format) {
+  const size_t n = this->size();
+  const size_t m = n / 2;
+  size_t c = 0;
+  format.with_converter([&](auto convert) {
+    for (; c + 1 < this->channels_; c += 2) {
+      this->forward_pair_(frames + c * n, frames + (c + 1) * n, this->real_.data() + c * this->stride_,
+                          this->imag_.data() + c * this->stride_, out + c * m, convert);
+    }
+  });
+  if (c < this->channels_) {
+    this->plan_.forward_spectrum(frames + c * n, this->real_.data() + c * this->stride_,
+                                 this->imag_.data() + c * this->stride_, out + c * m, format);
+  }
+}
+
+// real/imag span both channel blocks, 2 * (n/2 + 1) floats, and end up holding
+// channel a's bins in the first block and channel b's in the second. With out
+// set, the n/2 output bins of a then b are written there as they are split.
+template<typename Convert>
+void MultiChannelFFT::forward_pair_(const float *a, const float *b, float *real, float *imag, float *out,
+                                    Convert convert) const {
+  const size_t n = this->size();
+  const size_t m = n / 2;
+  const float *w = this->plan_.window();
+  for (size_t i = 0; i < n; i++) {
+    real[i] = a[i] * w[i];
+    imag[i] = b[i] * w[i];
+  }
+  this->plan_.forward(real, imag);
+
+  // With z = a + ib: A[k] = (Z[k] + conj(Z[n-k])) / 2 and B[k] = (Z[k] - conj(Z[n-k])) / 2i.
+  // Going up in k, A[k] overwrites Z[k] and B[k] is stored backwards from the
+  // end of the second block, into the slot Z[n-k+1] that step k-1 has just
+  // consumed; one reversal then puts B in order.
+  for (size_t k = 0; k <= m; k++) {
+    const size_t j = k == 0 ? 0 : n - k;
+    const float zr = real[k], zi = imag[k];
+    const float cr = real[j], ci = imag[j];
+    const float ar = 0.5f * (zr + cr), ai = 0.5f * (zi - ci);
+    const float br = 0.5f * (zi + ci), bi = -0.5f * (zr - cr);
+    real[k] = ar;
+    imag[k] = ai;
+    real[n + 1 - k] = br;
+    imag[n + 1 - k] = bi;
+    if (out != nullptr && k < m) {
+      out[k] = convert(ar * ar + ai * ai);
+      out[m + k] = convert(br * br + bi * bi);
+    }
+  }
+  std::reverse(real + m + 1, real + n + 2);
+  std::reverse(imag + m + 1, imag + n + 2);
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
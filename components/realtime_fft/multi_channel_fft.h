@@ -0,0 +1,60 @@
+#pragma once
+
+#include "fft_plan.h"
+#include <cstddef>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Windowed real-input FFT of several channels that share one plan.
+//
+// Channels are taken in pairs: the first goes into the real and the second
+// into the imaginary part of one full-size complex FFT, and the two spectra are
+// split apart afterwards using the conjugate symmetry of real signals. A pair
+// therefore costs one transform plus a split pass that needs no twiddles,
+// instead of two half-size transforms and two twiddled recombinations. An odd
+// last channel goes through the plan's usual real path.
+//
+// Input is planar, channel c at frames + c * size(), as StftFramer hands it
+// out. Complex bins 0..size()/2 of channel c are kept in real(c)/imag(c) and
+// all output bins are written to one contiguous block, channel c at
+// out + c * size()/2, from inside the split pass.
+class MultiChannelFFT {
+ public:
+  MultiChannelFFT(size_t size, size_t channels);
+
+  bool is_valid() const { return this->plan_.is_valid() && this->channels_ != 0; }
+  size_t size() const { return this->plan_.size(); }
+  size_t channels() const { return this->channels_; }
+  const FFTPlan &plan() const { return this->plan_; }
+  // Heap bytes held by the plan and the per-channel bins
+  size_t memory_bytes() const {
+    return this->plan_.memory_bytes() + (this->real_.size() + this->imag_.size()) * sizeof(float);
+  }
+
+  // Windows and transforms one planar frame per channel.
+  void forward(const float *frames);
+  // forward(), and size()/2 bins per channel into out in the given format.
+  void spectrum(const float *frames, float *out, const SpectrumFormat &format);
+  // Same, as magnitudes.
+  void magnitudes(const float *frames, float *out) { this->spectrum(frames, out, SpectrumFormat()); }
+
+  const float *real(size_t channel) const { return this->real_.data() + channel * this->stride_; }
+  const float *imag(size_t channel) const { return this->imag_.data() + channel * this->stride_; }
+
+ protected:
+  template<typename Convert>
+  void forward_pair_(const float *a, const float *b, float *real, float *imag, float *out, Convert convert) const;
+
+  FFTPlan plan_;
+  size_t channels_{0};
+  // size()/2 + 1 bins per channel; a pair's two blocks double as the work area
+  // of its full-size transform, which is why they are adjacent
+  size_t stride_{0};
+  InternalVector<float> real_;
+  InternalVector<float> imag_;
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,170 @@
+#include "multi_resolution_fft.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace realtime_fft {
+
+const FFTPlan *FFTPlanCache::get(size_t size) {
+  for (const auto &plan : this->plans_) {
+    if (plan->size() == size)
+      return plan.get();
+  }
+  if (!FFTPlan::is_supported_size(size))
+    return nullptr;
+  this->plans_.emplace_back(new FFTPlan(size));
+  return this->plans_.back().get();
+}
+
+size_t FFTPlanCache::memory_bytes() const {
+  size_t bytes = 0;
+  for (const auto &plan : this->plans_)
+    bytes += plan->memory_bytes();
+  return bytes;
+}
+
+// Frame copy plus the size/2 + 1 imaginary parts
+static size_t frame_floats(size_t size) { return size + size / 2 + 1; }
+
+size_t MultiResolutionFFT::ring_storage_size(const std::vector<AnalysisResolution> &resolutions) {
+  size_t largest = 0;
+  for (const AnalysisResolution &resolution : resolutions)
+    largest = std::max(largest, resolution.size);
+  return largest * sizeof(float);
+}
+
+size_t MultiResolutionFFT::frame_storage_size(const std::vector<AnalysisResolution> &resolutions) {
+  size_t floats = 0;
+  for (const AnalysisResolution &resolution : resolutions)
+    floats += frame_floats(resolution.size);
+  return floats * sizeof(float);
+}
+
+MultiResolutionFFT::MultiResolutionFFT(const std::vector<AnalysisResolution> &resolutions, float *ring,
+                                       float *frames) {
+  if (resolutions.empty())
+    return;
+  for (const AnalysisResolution &resolution : resolutions) {
+    const FFTPlan *plan = this->plans_.get(resolution.size);
+    if (plan == nullptr || resolution.hop_size == 0 || resolution.hop_size > resolution.size)
+      return;
+  }
+  this->ring_size_ = ring_storage_size(resolutions) / sizeof(float);
+  const size_t frame_size = frame_storage_size(resolutions) / sizeof(float);
+  this->owned_.resize((ring == nullptr ? this->ring_size_ : 0) + (frames == nullptr ? frame_size : 0));
+  this->ring_ = ring != nullptr ? ring : this->owned_.data();
+  if (frames == nullptr)
+    frames = this->owned_.data() + (ring == nullptr ? this->ring_size_ : 0);
+
+  this->smallest_ = resolutions[0].size;
+  for (const AnalysisResolution &resolution : resolutions) {
+    Resolution r{};
+    r.size = resolution.size;
+    r.hop_size = resolution.hop_size;
+    r.plan = this->plans_.get(resolution.size);
+    r.frame = frames;
+    r.imag = frames + resolution.size;
+    frames += frame_floats(resolution.size);
+    this->resolutions_.push_back(r);
+    this->smallest_ = std::min(this->smallest_, resolution.size);
+  }
+  this->reset();
+}
+
+void MultiResolutionFFT::reset() {
+  std::fill_n(this->ring_, this->ring_size_, 0.0f);
+  this->write_pos_ = 0;
+  for (Resolution &r : this->resolutions_) {
+    std::fill_n(r.imag, r.size / 2 + 1, 0.0f);
+    r.until_next = r.size;
+    r.pending = false;
+  }
+}
+
+void MultiResolutionFFT::capture_(Resolution &resolution) {
+  if (resolution.pending)
+    this->dropped_++;
+  // The last size samples end at the write position
+  const size_t n = resolution.size;
+  const size_t start = (this->write_pos_ + this->ring_size_ - n) % this->ring_size_;
+  const size_t tail = std::min(n, this->ring_size_ - start);
+  std::memcpy(resolution.frame, this->ring_ + start, tail * sizeof(float));
+  std::memcpy(resolution.frame + tail, this->ring_, (n - tail) * sizeof(float));
+  resolution.pending = true;
+  resolution.captured = this->captures_++;
+}
+
+template<typename OnDue>
+void MultiResolutionFFT::feed_(const float *samples, size_t count, size_t stride, OnDue on_due) {
+  size_t remaining = count;
+  while (remaining > 0) {
+    // Copy up to the next due frame or the end of the ring, whichever is first
+    size_t chunk = std::min(remaining, this->ring_size_ - this->write_pos_);
+    for (const Resolution &r : this->resolutions_)
+      chunk = std::min(chunk, r.until_next);
+    float *ring = this->ring_ + this->write_pos_;
+    for (size_t i = 0; i < chunk; i++)
+      ring[i] = samples[i * stride];
+    samples += chunk * stride;
+    remaining -= chunk;
+    this->write_pos_ = this->write_pos_ + chunk == this->ring_size_ ? 0 : this->write_pos_ + chunk;
+
+    for (Resolution &r : this->resolutions_) {
+      r.until_next -= chunk;
+      if (r.until_next != 0)
+        continue;
+      r.until_next = r.hop_size;
+      on_due(r);
+    }
+  }
+}
+
+size_t MultiResolutionFFT::push(const float *samples, size_t count, size_t stride, const SpectrumFormat &format,
+                                const FrameCallback &callback) {
+  size_t transforms = 0;
+  auto transform = [&](Resolution &r) {
+    // The frame copy doubles as the real part and the spectrum overwrites the imaginary part
+    r.plan->forward_spectrum(r.frame, r.frame, r.imag, r.imag, format);
+    r.pending = false;
+    callback(&r - this->resolutions_.data(), r.imag);
+    transforms++;
+  };
+
+  const size_t pushed = (count + stride - 1) / stride;
+  this->feed_(samples, pushed, stride, [&](Resolution &r) {
+    this->capture_(r);
+    // The smallest frames are cheap and never wait
+    if (r.size == this->smallest_)
+      transform(r);
+  });
+
+  // Then the larger frame that has waited longest, and any other that a call
+  // of the same length would replace before it got its turn
+  Resolution *oldest = nullptr;
+  for (Resolution &r : this->resolutions_) {
+    if (r.pending && (oldest == nullptr || static_cast<int32_t>(r.captured - oldest->captured) < 0))
+      oldest = &r;
+  }
+  if (oldest != nullptr)
+    transform(*oldest);
+  for (Resolution &r : this->resolutions_) {
+    if (r.pending && r.until_next <= pushed)
+      transform(r);
+  }
+  return transforms;
+}
+
+size_t MultiResolutionFFT::skip(const float *samples, size_t count, size_t stride) {
+  size_t skipped = 0;
+  for (Resolution &r : this->resolutions_) {
+    if (r.pending) {
+      r.pending = false;
+      skipped++;
+    }
+  }
+  this->feed_(samples, (count + stride - 1) / stride, stride, [&skipped](Resolution &) { skipped++; });
+  return skipped;
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
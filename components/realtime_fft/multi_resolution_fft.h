@@ -0,0 +1,119 @@
+#pragma once
+
+#include "fft_plan.h"
+#include "spectrum_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// One FFT plan per size, built on first use and shared by every user of that
+// size: tables and Hann window exist once however many analyses need them.
+// Plans of non-power-of-two sizes hold scratch, so a cache belongs to one task.
+class FFTPlanCache {
+ public:
+  // Plan for size, or nullptr if the size is not supported
+  const FFTPlan *get(size_t size);
+  // Heap bytes held by the cached plans
+  size_t memory_bytes() const;
+
+ protected:
+  std::vector<std::unique_ptr<FFTPlan>> plans_;
+};
+
+struct AnalysisResolution {
+  size_t size;
+  size_t hop_size;
+};
+
+// Several FFT sizes over one mono input stream, e.g. 256 points for transients
+// and 4096 for bass detail.
+//
+// Samples are written once to a shared ring as long as the largest frame;
+// every resolution counts its own hops and, when one is due, copies its last
+// size samples out of the ring, so frames are cut at the exact sample whatever
+// the chunk sizes. Frames of the smallest size are transformed on the spot;
+// larger ones wait for the end of push(), which runs the oldest of them plus
+// only those that the next call, if as long as this one, would replace. Larger
+// frames that fall due together are thereby spread over successive calls
+// instead of all landing in one. A frame still waiting when its resolution is
+// due again is replaced by the newer one and counted as dropped, which only
+// happens when a larger resolution's hop is shorter than the pushed chunks.
+//
+// The ring and the per-resolution frame buffers can be handed in (e.g. from a
+// MemoryArena). Each resolution's spectrum, size/2 bins in the format given
+// to push(), stays readable until its next transform.
+class MultiResolutionFFT {
+ public:
+  // Called after each transform with the resolution's index and spectrum
+  using FrameCallback = std::function<void(size_t resolution, const float *spectrum)>;
+
+  MultiResolutionFFT(const std::vector<AnalysisResolution> &resolutions, float *ring = nullptr,
+                     float *frames = nullptr);
+
+  // Bytes of the shared ring and of the frame buffers for these resolutions
+  static size_t ring_storage_size(const std::vector<AnalysisResolution> &resolutions);
+  static size_t frame_storage_size(const std::vector<AnalysisResolution> &resolutions);
+
+  bool is_valid() const { return !this->resolutions_.empty(); }
+  size_t resolution_count() const { return this->resolutions_.size(); }
+  size_t size(size_t resolution) const { return this->resolutions_[resolution].size; }
+  size_t hop_size(size_t resolution) const { return this->resolutions_[resolution].hop_size; }
+  const FFTPlan &plan(size_t resolution) const { return *this->resolutions_[resolution].plan; }
+  float *spectrum(size_t resolution) const { return this->resolutions_[resolution].imag; }
+  // Frames replaced while waiting for their transform, over all resolutions
+  uint32_t dropped_frames() const { return this->dropped_; }
+  // Heap bytes held by the plans
+  size_t memory_bytes() const { return this->plans_.memory_bytes(); }
+
+  // Appends count samples, taking every stride-th one (channel 0 of
+  // interleaved input), then runs the due transforms. Returns their number.
+  size_t push(const float *samples, size_t count, size_t stride, const SpectrumFormat &format,
+              const FrameCallback &callback);
+
+  // Appends samples like push() but transforms nothing: frames falling due and
+  // those still waiting are discarded, uncounted, while the ring and the hop
+  // schedules stay current. Returns the number of frames left out.
+  size_t skip(const float *samples, size_t count, size_t stride);
+
+  // Drops buffered samples and waiting frames; every resolution needs a full
+  // frame of new input before its next transform.
+  void reset();
+
+ protected:
+  struct Resolution {
+    size_t size;
+    size_t hop_size;
+    const FFTPlan *plan;
+    // Frame copy, then the real parts of the bins
+    float *frame;
+    // Imaginary parts of the bins, then the spectrum
+    float *imag;
+    size_t until_next;
+    bool pending;
+    // Order of capture, so the oldest waiting frame goes first
+    uint32_t captured;
+  };
+
+  // Writes count samples, stride apart, to the ring, calling on_due for every
+  // frame falling due
+  template<typename OnDue> void feed_(const float *samples, size_t count, size_t stride, OnDue on_due);
+  void capture_(Resolution &resolution);
+
+  FFTPlanCache plans_;
+  std::vector<Resolution> resolutions_;
+  std::vector<float> owned_;
+  float *ring_{nullptr};
+  size_t ring_size_{0};
+  size_t write_pos_{0};
+  size_t smallest_{0};
+  uint32_t captures_{0};
+  uint32_t dropped_{0};
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,194 @@
+#ifndef ESP_PLATFORM
+
+#include "pcm_file_source.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace esphome {
+namespace realtime_fft {
+
+static size_t encoding_size(PcmEncoding encoding) {
+  switch (encoding) {
+    case PCM_U8:
+      return 1;
+    case PCM_S16LE:
+      return 2;
+    case PCM_S24LE:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+static uint32_t read_le(const uint8_t *p, size_t bytes) {
+  uint32_t v = 0;
+  for (size_t i = 0; i < bytes; i++)
+    v |= static_cast<uint32_t>(p[i]) << (8 * i);
+  return v;
+}
+
+PcmFileSource::PcmFileSource(const char *path) {
+  if (this->map(path) && !this->parse_wav())
+    this->samples_ = nullptr;
+}
+
+PcmFileSource::PcmFileSource(const char *path, PcmEncoding encoding, int channels, int sample_rate)
+    : encoding_(encoding), file_channels_(channels), file_sample_rate_(sample_rate) {
+  if (!this->map(path))
+    return;
+  if (channels < 1) {
+    this->error_ = "invalid channel count";
+    return;
+  }
+  this->samples_ = this->data_;
+  this->frames_ = this->size_ / (encoding_size(encoding) * channels);
+}
+
+PcmFileSource::~PcmFileSource() {
+  if (this->data_ != nullptr)
+    munmap(const_cast<uint8_t *>(this->data_), this->size_);
+}
+
+bool PcmFileSource::map(const char *path) {
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    this->error_ = "cannot open file";
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    this->error_ = "empty file";
+    return false;
+  }
+  void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    this->error_ = "mmap failed";
+    return false;
+  }
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+  this->data_ = static_cast<const uint8_t *>(data);
+  this->size_ = st.st_size;
+  return true;
+}
+
+bool PcmFileSource::parse_wav() {
+  const uint8_t *p = this->data_;
+  if (this->size_ < 12 || std::memcmp(p, "RIFF", 4) != 0 || std::memcmp(p + 8, "WAVE", 4) != 0) {
+    this->error_ = "not a WAV file";
+    return false;
+  }
+  bool have_format = false;
+  size_t offset = 12;
+  while (offset + 8 <= this->size_) {
+    const uint8_t *chunk = p + offset;
+    const size_t length = read_le(chunk + 4, 4);
+    const size_t available = std::min(length, this->size_ - offset - 8);
+    if (std::memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+      uint32_t tag = read_le(chunk + 8, 2);
+      // WAVE_FORMAT_EXTENSIBLE keeps the real tag at the start of the sub-format GUID
+      if (tag == 0xFFFE && available >= 26)
+        tag = read_le(chunk + 32, 2);
+      this->file_channels_ = read_le(chunk + 10, 2);
+      this->file_sample_rate_ = read_le(chunk + 12, 4);
+      const uint32_t bits = read_le(chunk + 22, 2);
+      if (tag == 3 && bits == 32) {
+        this->encoding_ = PCM_F32LE;
+      } else if (tag == 1 && bits == 8) {
+        this->encoding_ = PCM_U8;
+      } else if (tag == 1 && bits == 16) {
+        this->encoding_ = PCM_S16LE;
+      } else if (tag == 1 && bits == 24) {
+        this->encoding_ = PCM_S24LE;
+      } else if (tag == 1 && bits == 32) {
+        this->encoding_ = PCM_S32LE;
+      } else {
+        this->error_ = "unsupported WAV sample format";
+        return false;
+      }
+      have_format = this->file_channels_ > 0;
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      if (!have_format) {
+        this->error_ = "WAV data before fmt chunk";
+        return false;
+      }
+      this->samples_ = chunk + 8;
+      this->frames_ = available / (encoding_size(this->encoding_) * this->file_channels_);
+      return true;
+    }
+    // Chunks are padded to even lengths
+    offset += 8 + length + (length & 1);
+  }
+  this->error_ = "WAV file has no data chunk";
+  return false;
+}
+
+bool PcmFileSource::open(SampleFormat format, int sample_rate, int channels) {
+  if (!this->is_valid())
+    return false;
+  if (this->channel_ < 0 || channels < 1 || this->channel_ + channels > this->file_channels_) {
+    this->error_ = "file has fewer channels than requested";
+    return false;
+  }
+  if (sample_rate != this->file_sample_rate_) {
+    this->error_ = "sample rate differs from the file";
+    return false;
+  }
+  this->position_ = 0;
+  return AudioSource::open(format, sample_rate, channels);
+}
+
+double PcmFileSource::decode(size_t frame, int channel) const {
+  const size_t size = encoding_size(this->encoding_);
+  const uint8_t *p = this->samples_ + (frame * this->file_channels_ + channel) * size;
+  switch (this->encoding_) {
+    case PCM_U8:
+      return (p[0] - 128) / 128.0;
+    case PCM_S16LE:
+      return static_cast<int16_t>(read_le(p, 2)) / 32768.0;
+    case PCM_S24LE:
+      // Shift into the top of an int32 to sign-extend
+      return static_cast<int32_t>(read_le(p, 3) << 8) / 2147483648.0;
+    case PCM_S32LE:
+      return static_cast<int32_t>(read_le(p, 4)) / 2147483648.0;
+    default: {
+      const uint32_t bits = read_le(p, 4);
+      float v;
+      std::memcpy(&v, &bits, sizeof(v));
+      return v;
+    }
+  }
+}
+
+size_t PcmFileSource::read(uint8_t *dst, size_t max_bytes) {
+  const size_t frame_bytes = sample_format_size(this->format_) * this->channels_;
+  const size_t count = max_bytes / frame_bytes;
+  size_t produced = 0;
+  while (produced < count) {
+    if (this->position_ >= this->frames_) {
+      if (!this->loop_ || this->frames_ == 0)
+        break;
+      this->position_ = 0;
+    }
+    uint8_t *frame = dst + produced * frame_bytes;
+    for (int c = 0; c < this->channels_; c++) {
+      encode_sample(this->decode(this->position_, this->channel_ + c), this->format_,
+                    frame + c * sample_format_size(this->format_));
+    }
+    this->position_++;
+    produced++;
+  }
+  this->pace(produced);
+  return produced * frame_bytes;
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
+
+#endif  // ESP_PLATFORM
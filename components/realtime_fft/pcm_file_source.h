@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef ESP_PLATFORM
+
+#include "audio_source.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Encoding of samples stored in a PCM file, little-endian, channels interleaved
+enum PcmEncoding : uint8_t {
+  PCM_U8 = 0,
+  PCM_S16LE,
+  PCM_S24LE,
+  PCM_S32LE,
+  PCM_F32LE,
+};
+
+// Replays a WAV or headerless PCM file through the pipeline on a host.
+//
+// The file is memory-mapped rather than read, so replaying long recordings
+// costs no copies beyond the conversion into the pipeline's sample format and
+// the page cache serves repeated runs. The pipeline's channels are taken from
+// interleaved files starting at set_channel(), 0 by default. Samples are
+// delivered as fast as the pipeline takes them, which is what profiling wants;
+// set_realtime(true) replays at the file's pace.
+class PcmFileSource : public AudioSource {
+ public:
+  // WAV file: format, channels and rate come from the header.
+  explicit PcmFileSource(const char *path);
+  // Headerless file in the given layout.
+  PcmFileSource(const char *path, PcmEncoding encoding, int channels, int sample_rate);
+  ~PcmFileSource() override;
+
+  PcmFileSource(const PcmFileSource &) = delete;
+  PcmFileSource &operator=(const PcmFileSource &) = delete;
+
+  bool is_valid() const { return this->samples_ != nullptr; }
+  const char *error() const { return this->error_; }
+  int file_sample_rate() const { return this->file_sample_rate_; }
+  int file_channels() const { return this->file_channels_; }
+  size_t frames() const { return this->frames_; }
+
+  // First file channel delivered
+  void set_channel(int channel) { this->channel_ = channel; }
+  // Start over at the end instead of reporting end of input
+  void set_loop(bool loop) { this->loop_ = loop; }
+  void rewind() { this->position_ = 0; }
+
+  // Fails if the rate differs from the file's (there is no resampler) or the
+  // file doesn't have enough channels.
+  bool open(SampleFormat format, int sample_rate, int channels = 1) override;
+  size_t read(uint8_t *dst, size_t max_bytes) override;
+  const char *name() const override { return "file"; }
+
+ protected:
+  bool map(const char *path);
+  bool parse_wav();
+  double decode(size_t frame, int channel) const;
+
+  const uint8_t *data_{nullptr};
+  size_t size_{0};
+  const uint8_t *samples_{nullptr};
+  size_t frames_{0};
+  PcmEncoding encoding_{PCM_S16LE};
+  int file_channels_{1};
+  int file_sample_rate_{0};
+  int channel_{0};
+  bool loop_{false};
+  size_t position_{0};
+  const char *error_{nullptr};
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
+
+#endif  // ESP_PLATFORM
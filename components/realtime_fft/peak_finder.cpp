@@ -0,0 +1,99 @@
+#include "peak_finder.h"
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace realtime_fft {
+
+static bool stronger(const Peak &a, const Peak &b) { return a.magnitude > b.magnitude; }
+
+// Vertex of the parabola through (-1, a), (0, b), (1, c); offset in [-0.5, 0.5]
+static float parabola_offset(float a, float b, float c) {
+  const float denom = a - 2.0f * b + c;
+  if (denom >= 0.0f)
+    return 0.0f;
+  return std::max(-0.5f, std::min(0.5f, 0.5f * (a - c) / denom));
+}
+
+PeakFinder::PeakFinder(size_t max_peaks, size_t min_spacing, float threshold)
+    : max_peaks_(max_peaks), min_spacing_(min_spacing), threshold_(threshold) {
+  this->peaks_.reserve(max_peaks);
+}
+
+// Refines the magnitude from the log parabola, fills in the offset if not given
+void PeakFinder::refine(Peak &peak, const float *spectrum, bool have_offset, float offset) const {
+  const size_t k = static_cast<size_t>(peak.bin);
+  const float a = this->format_.to_log_magnitude(spectrum[k - 1]);
+  const float b = this->format_.to_log_magnitude(spectrum[k]);
+  const float c = this->format_.to_log_magnitude(spectrum[k + 1]);
+  const float p = parabola_offset(a, b, c);
+  if (!have_offset)
+    offset = p;
+  peak.bin = k + offset;
+  peak.magnitude = std::exp(b - 0.25f * (a - c) * p);
+}
+
+size_t PeakFinder::find(const float *spectrum, size_t count) {
+  this->select(spectrum, count);
+  for (Peak &peak : this->peaks_)
+    this->refine(peak, spectrum, false, 0.0f);
+  return this->peaks_.size();
+}
+
+size_t PeakFinder::find(const float *spectrum, const float *real, const float *imag, size_t count) {
+  this->select(spectrum, count);
+  for (Peak &peak : this->peaks_) {
+    const size_t k = static_cast<size_t>(peak.bin);
+    // delta = 2 * Re((X[k-1] - X[k+1]) / (2 X[k] - X[k-1] - X[k+1])) for Hann windows
+    const float nr = real[k - 1] - real[k + 1], ni = imag[k - 1] - imag[k + 1];
+    const float dr = 2.0f * real[k] - real[k - 1] - real[k + 1];
+    const float di = 2.0f * imag[k] - imag[k - 1] - imag[k + 1];
+    const float norm = dr * dr + di * di;
+    float offset = norm > 0.0f ? 2.0f * (nr * dr + ni * di) / norm : 0.0f;
+    offset = std::max(-0.5f, std::min(0.5f, offset));
+    this->refine(peak, spectrum, true, offset);
+  }
+  return this->peaks_.size();
+}
+
+void PeakFinder::select(const float *spectrum, size_t count) {
+  this->peaks_.clear();
+  if (this->max_peaks_ == 0 || count < 3)
+    return;
+
+  // A local maximum is held back until the next one is far enough away, so a
+  // stronger maximum within min_spacing can still replace it
+  size_t pending = 0;
+  for (size_t k = 1; k + 1 < count; k++) {
+    const float m = spectrum[k];
+    if (m <= this->threshold_ || m <= spectrum[k - 1] || m < spectrum[k + 1])
+      continue;
+    if (pending != 0 && k - pending < this->min_spacing_) {
+      if (m > spectrum[pending])
+        pending = k;
+      continue;
+    }
+    if (pending != 0)
+      this->offer(pending, spectrum[pending]);
+    pending = k;
+  }
+  if (pending != 0)
+    this->offer(pending, spectrum[pending]);
+
+  std::sort_heap(this->peaks_.begin(), this->peaks_.end(), stronger);
+}
+
+// Peaks hold the raw bin value until refine() turns it into a magnitude
+void PeakFinder::offer(size_t bin, float value) {
+  if (this->peaks_.size() == this->max_peaks_) {
+    if (value <= this->peaks_.front().magnitude)
+      return;
+    std::pop_heap(this->peaks_.begin(), this->peaks_.end(), stronger);
+    this->peaks_.pop_back();
+  }
+  this->peaks_.push_back(Peak{static_cast<float>(bin), value});
+  std::push_heap(this->peaks_.begin(), this->peaks_.end(), stronger);
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
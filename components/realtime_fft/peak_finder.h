@@ -0,0 +1,64 @@
+#pragma once
+
+#include "spectrum_format.h"
+#include <cstddef>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// One spectral peak; bin is fractional after interpolation and magnitude is
+// linear |X| whatever the spectrum's format.
+struct Peak {
+  float bin;
+  float magnitude;
+};
+
+// Finds the strongest local maxima of a spectrum in a single pass.
+//
+// Candidates closer than min_spacing bins to a stronger neighbour are merged
+// into it, so one window lobe yields one peak, and only the best max_peaks are
+// kept in a bounded heap. Just those are refined to sub-bin frequency and
+// magnitude: a parabola through the log magnitudes of the three bins around the
+// maximum, or Jacobsen's estimator when the complex bins are at hand (with the
+// factor 2 that makes it unbiased for the Hann window used by the transforms).
+// Bin 0 and the last bin are never reported. Storage is reserved up front, so
+// find() doesn't allocate.
+//
+// The scan only compares bins, so it runs on magnitude, power or dB values as
+// they are; the format only comes in for the few refined peaks, and the
+// threshold is in the spectrum's own scale.
+class PeakFinder {
+ public:
+  explicit PeakFinder(size_t max_peaks, size_t min_spacing = 2, float threshold = 0.0f);
+
+  size_t max_peaks() const { return this->max_peaks_; }
+  void set_min_spacing(size_t min_spacing) { this->min_spacing_ = min_spacing; }
+  void set_threshold(float threshold) { this->threshold_ = threshold; }
+  void set_format(const SpectrumFormat &format) { this->format_ = format; }
+
+  // Detects peaks in count bins; returns how many were found.
+  size_t find(const float *spectrum, size_t count);
+  // Same, refining with the complex bins the spectrum came from.
+  size_t find(const float *spectrum, const float *real, const float *imag, size_t count);
+
+  // Results of the last find(), strongest first.
+  const Peak *peaks() const { return this->peaks_.data(); }
+  size_t size() const { return this->peaks_.size(); }
+  const Peak &operator[](size_t i) const { return this->peaks_[i]; }
+
+ protected:
+  void select(const float *spectrum, size_t count);
+  void offer(size_t bin, float value);
+  void refine(Peak &peak, const float *spectrum, bool have_offset, float offset) const;
+
+  size_t max_peaks_;
+  size_t min_spacing_;
+  float threshold_;
+  SpectrumFormat format_;
+  // Min-heap on bin value while scanning, sorted strongest first afterwards
+  std::vector<Peak> peaks_;
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
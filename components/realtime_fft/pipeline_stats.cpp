@@ -0,0 +1,109 @@
+#include "pipeline_stats.h"
+#include <algorithm>
+#include <chrono>
+
+namespace esphome {
+namespace realtime_fft {
+
+static uint32_t steady_clock_ns() {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+const char *stage_to_string(Stage stage) {
+  switch (stage) {
+    case STAGE_READ:
+      return "read";
+    case STAGE_FFT:
+      return "fft";
+    case STAGE_MAGNITUDE:
+      return "magnitude";
+    case STAGE_PUBLISH:
+      return "publish";
+    case STAGE_FRAME:
+      return "frame";
+    default:
+      return "unknown";
+  }
+}
+
+size_t LatencyHistogram::bucket_of(uint32_t ticks) {
+  if (ticks < SUB_BUCKETS)
+    return ticks;
+  // Octave from the top set bit, sub-bucket from the two bits below it
+  const int octave = 31 - __builtin_clz(ticks);
+  const size_t sub = (ticks >> (octave - 2)) & (SUB_BUCKETS - 1);
+  return (octave - 1) * SUB_BUCKETS + sub;
+}
+
+uint32_t LatencyHistogram::bucket_upper(size_t bucket) {
+  if (bucket < SUB_BUCKETS)
+    return bucket;
+  const int octave = bucket / SUB_BUCKETS + 1;
+  const uint64_t sub = bucket % SUB_BUCKETS;
+  const uint64_t upper = ((SUB_BUCKETS + sub + 1) << (octave - 2)) - 1;
+  return upper > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(upper);
+}
+
+void LatencyHistogram::record(uint32_t ticks) {
+  this->buckets_[bucket_of(ticks)].fetch_add(1, std::memory_order_relaxed);
+  this->count_.fetch_add(1, std::memory_order_relaxed);
+  this->sum_.fetch_add(ticks, std::memory_order_relaxed);
+  // Only one task records into a given histogram, so load/store is enough
+  if (ticks < this->min_.load(std::memory_order_relaxed))
+    this->min_.store(ticks, std::memory_order_relaxed);
+  if (ticks > this->max_.load(std::memory_order_relaxed))
+    this->max_.store(ticks, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+  for (auto &bucket : this->buckets_)
+    bucket.store(0, std::memory_order_relaxed);
+  this->count_.store(0, std::memory_order_relaxed);
+  this->sum_.store(0, std::memory_order_relaxed);
+  this->min_.store(UINT32_MAX, std::memory_order_relaxed);
+  this->max_.store(0, std::memory_order_relaxed);
+}
+
+uint32_t LatencyHistogram::min() const {
+  const uint32_t min = this->min_.load(std::memory_order_relaxed);
+  return min == UINT32_MAX ? 0 : min;
+}
+
+float LatencyHistogram::mean() const {
+  const uint32_t count = this->count();
+  return count > 0 ? static_cast<float>(this->sum_.load(std::memory_order_relaxed)) / count : 0.0f;
+}
+
+uint32_t LatencyHistogram::percentile(float q) const {
+  const uint32_t count = this->count();
+  if (count == 0)
+    return 0;
+  const uint64_t target = static_cast<uint64_t>(q * count + 0.5f);
+  uint64_t seen = 0;
+  for (size_t b = 0; b < BUCKETS; b++) {
+    seen += this->buckets_[b].load(std::memory_order_relaxed);
+    if (seen >= target && seen > 0)
+      return std::min(bucket_upper(b), this->max());
+  }
+  return this->max();
+}
+
+PipelineStats::PipelineStats(ClockFunction clock, uint32_t clock_hz)
+    : clock_(clock != nullptr ? clock : steady_clock_ns), clock_hz_(clock != nullptr ? clock_hz : 1000000000) {}
+
+float PipelineStats::take_cpu_load(uint32_t elapsed_ms) {
+  const uint64_t busy = this->busy_ticks_.exchange(0, std::memory_order_relaxed);
+  if (elapsed_ms == 0)
+    return 0.0f;
+  return 100.0f * this->ticks_to_us(static_cast<float>(busy)) / (elapsed_ms * 1000.0f);
+}
+
+void PipelineStats::reset_stages() {
+  for (auto &stage : this->stages_)
+    stage.reset();
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
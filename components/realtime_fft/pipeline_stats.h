@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Hot-path stages that get their own latency histogram
+enum Stage : uint8_t {
+  // Taking one hop of samples off the capture queue
+  STAGE_READ = 0,
+  // Window and transform; every engine fuses the window into its first pass
+  STAGE_FFT,
+  // Bin format conversion, where the engine doesn't fuse it into the transform
+  STAGE_MAGNITUDE,
+  // Peak search, bands, aggregation and sensor updates
+  STAGE_PUBLISH,
+  // Whole frame, from a completed frame to its spectrum being handed on
+  STAGE_FRAME,
+  STAGE_COUNT,
+};
+
+const char *stage_to_string(Stage stage);
+
+// Log-linear histogram of durations in clock ticks: four buckets per power of
+// two, so percentiles are within 25% and recording is a count-leading-zeros and
+// a few relaxed atomic adds. Safe to record from one task while another reads.
+class LatencyHistogram {
+ public:
+  void record(uint32_t ticks);
+  void reset();
+
+  uint32_t count() const { return this->count_.load(std::memory_order_relaxed); }
+  uint32_t min() const;
+  uint32_t max() const { return this->max_.load(std::memory_order_relaxed); }
+  float mean() const;
+  // Upper edge of the bucket holding the q-quantile, 0 < q <= 1.
+  uint32_t percentile(float q) const;
+
+ protected:
+  static constexpr size_t SUB_BUCKETS = 4;
+  static constexpr size_t BUCKETS = 32 * SUB_BUCKETS;
+
+  static size_t bucket_of(uint32_t ticks);
+  static uint32_t bucket_upper(size_t bucket);
+
+  std::atomic<uint32_t> buckets_[BUCKETS]{};
+  std::atomic<uint32_t> count_{0};
+  std::atomic<uint32_t> min_{UINT32_MAX};
+  std::atomic<uint32_t> max_{0};
+  std::atomic<uint64_t> sum_{0};
+};
+
+// Timing and loss counters for the capture -> FFT -> publish pipeline.
+//
+// Durations are in ticks of a caller-supplied free-running clock, normally the
+// CPU cycle counter, and converted to microseconds on the way out. Busy time
+// (see ScopedBusy) over wall time gives the CPU load of the pipeline, as a
+// percentage of one core; with the compute task on the other core it can
+// exceed 100.
+class PipelineStats {
+ public:
+  using ClockFunction = uint32_t (*)();
+
+  // A null clock uses a 1 GHz clock derived from std::chrono.
+  PipelineStats(ClockFunction clock = nullptr, uint32_t clock_hz = 1000000000);
+
+  uint32_t now() const { return this->clock_(); }
+  float ticks_to_us(float ticks) const { return ticks * 1e6f / this->clock_hz_; }
+
+  void record(Stage stage, uint32_t ticks) { this->stages_[stage].record(ticks); }
+  void add_busy(uint32_t ticks) { this->busy_ticks_.fetch_add(ticks, std::memory_order_relaxed); }
+  void add_dropped_frames(uint32_t frames) { this->dropped_frames_.fetch_add(frames, std::memory_order_relaxed); }
+
+  const LatencyHistogram &stage(Stage stage) const { return this->stages_[stage]; }
+  uint32_t dropped_frames() const { return this->dropped_frames_.load(std::memory_order_relaxed); }
+
+  // Busy percentage since the previous call, given the wall time elapsed in ms.
+  float take_cpu_load(uint32_t elapsed_ms);
+  // Clears the histograms, e.g. at the start of each reporting window.
+  void reset_stages();
+
+ protected:
+  ClockFunction clock_;
+  uint32_t clock_hz_;
+  LatencyHistogram stages_[STAGE_COUNT];
+  std::atomic<uint64_t> busy_ticks_{0};
+  std::atomic<uint32_t> dropped_frames_{0};
+};
+
+// Times a scope into one stage histogram. With REALTIME_FFT_NO_INSTRUMENTATION
+// defined this and ScopedBusy compile to nothing.
+class ScopedStage {
+ public:
+#ifndef REALTIME_FFT_NO_INSTRUMENTATION
+  ScopedStage(PipelineStats *stats, Stage stage)
+      : stats_(stats), stage_(stage), start_(stats != nullptr ? stats->now() : 0) {}
+  ~ScopedStage() {
+    if (this->stats_ != nullptr)
+      this->stats_->record(this->stage_, this->stats_->now() - this->start_);
+  }
+
+ protected:
+  PipelineStats *stats_;
+  Stage stage_;
+  uint32_t start_;
+#else
+  ScopedStage(PipelineStats *, Stage) {}
+#endif
+};
+
+// Counts a scope as pipeline busy time for the CPU load figure.
+class ScopedBusy {
+ public:
+#ifndef REALTIME_FFT_NO_INSTRUMENTATION
+  explicit ScopedBusy(PipelineStats *stats) : stats_(stats), start_(stats != nullptr ? stats->now() : 0) {}
+  ~ScopedBusy() {
+    if (this->stats_ != nullptr)
+      this->stats_->add_busy(this->stats_->now() - this->start_);
+  }
+
+ protected:
+  PipelineStats *stats_;
+  uint32_t start_;
+#else
+  explicit ScopedBusy(PipelineStats *) {}
+#endif
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
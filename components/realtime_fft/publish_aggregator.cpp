@@ -0,0 +1,83 @@
+#include "publish_aggregator.h"
+#include <cmath>
+
+namespace esphome {
+namespace realtime_fft {
+
+PublishAggregator::PublishAggregator(size_t channels, AggregateMode mode, uint32_t window_frames, uint32_t window_ms)
+    : mode_(mode),
+      window_frames_(window_frames),
+      window_ms_(window_ms),
+      sums_(channels, 0.0f),
+      counts_(channels, 0),
+      values_(channels, NAN),
+      published_(channels, NAN) {}
+
+bool PublishAggregator::add(const float *values, uint32_t now_ms) {
+  if (this->frames_ == 0)
+    this->window_start_ = now_ms;
+  this->frames_++;
+
+  for (size_t c = 0; c < this->sums_.size(); c++) {
+    const float v = values[c];
+    if (std::isnan(v))
+      continue;
+    switch (this->mode_) {
+      case AGGREGATE_MAX:
+        if (this->counts_[c] == 0 || v > this->sums_[c])
+          this->sums_[c] = v;
+        break;
+      case AGGREGATE_RMS:
+        this->sums_[c] += v * v;
+        break;
+      case AGGREGATE_LAST:
+        this->sums_[c] = v;
+        break;
+      default:
+        this->sums_[c] += v;
+        break;
+    }
+    this->counts_[c]++;
+  }
+
+  const bool by_frames = this->window_frames_ > 0 && this->frames_ >= this->window_frames_;
+  const bool by_time = this->window_ms_ > 0 && now_ms - this->window_start_ >= this->window_ms_;
+  if (!by_frames && !by_time && (this->window_frames_ > 0 || this->window_ms_ > 0))
+    return false;
+
+  for (size_t c = 0; c < this->sums_.size(); c++) {
+    const uint32_t n = this->counts_[c];
+    float v = NAN;
+    if (n > 0) {
+      switch (this->mode_) {
+        case AGGREGATE_MEAN:
+          v = this->sums_[c] / n;
+          break;
+        case AGGREGATE_RMS:
+          v = std::sqrt(this->sums_[c] / n);
+          break;
+        default:
+          v = this->sums_[c];
+          break;
+      }
+    }
+    this->values_[c] = v;
+    this->sums_[c] = 0.0f;
+    this->counts_[c] = 0;
+  }
+  this->frames_ = 0;
+  return true;
+}
+
+bool PublishAggregator::should_publish(size_t channel, float value) {
+  const float last = this->published_[channel];
+  if (std::isnan(value) && std::isnan(last))
+    return false;
+  if (!std::isnan(value) && !std::isnan(last) && std::fabs(value - last) <= this->delta_)
+    return false;
+  this->published_[channel] = value;
+  return true;
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
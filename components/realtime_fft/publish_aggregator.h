@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// How the per-frame values of a window are combined
+enum AggregateMode : uint8_t {
+  AGGREGATE_MEAN = 0,
+  AGGREGATE_MAX,
+  AGGREGATE_RMS,
+  // Newest value only, i.e. plain decimation
+  AGGREGATE_LAST,
+};
+
+// Folds per-frame values into one value per publish window.
+//
+// Every frame is accumulated, so nothing computed is thrown away; a window
+// closes after a number of frames or milliseconds (whichever comes first, 0
+// disables that limit, both 0 closes it every frame). Each channel then also
+// passes a change gate: its value is only reported when it moved by more than
+// the delta since it was last reported. NaN frames are left out of a window.
+class PublishAggregator {
+ public:
+  PublishAggregator(size_t channels, AggregateMode mode, uint32_t window_frames, uint32_t window_ms);
+
+  void set_delta(float delta) { this->delta_ = delta; }
+  size_t channels() const { return this->sums_.size(); }
+
+  // Accumulates one frame of channels() values; returns true when the window
+  // just closed and value() holds its result.
+  bool add(const float *values, uint32_t now_ms);
+  // Aggregate of the last closed window, NaN if it had no finite value.
+  float value(size_t channel) const { return this->values_[channel]; }
+
+  // Change gate on the value actually published (e.g. after a dB conversion):
+  // returns true and remembers it when it differs from the last one by more than delta.
+  bool should_publish(size_t channel, float value);
+
+ protected:
+  AggregateMode mode_;
+  uint32_t window_frames_;
+  uint32_t window_ms_;
+  float delta_{0.0f};
+
+  uint32_t frames_{0};
+  uint32_t window_start_{0};
+  std::vector<float> sums_;
+  std::vector<uint32_t> counts_;
+  std::vector<float> values_;
+  std::vector<float> published_;
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
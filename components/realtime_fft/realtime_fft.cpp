@@ -1,5 +1,6 @@
 #include "realtime_fft.h"
 #include "esphome/core/log.h"
+#include "esphome/core/hal.h"
 
 namespace esphome {
 namespace realtime_fft {
@@ -9,129 +10,868 @@ static const char *TAG = "realtime_fft";
 void RealtimeFFTComponent::setup() {
   ESP_LOGD(TAG, "Setting up Realtime FFT...");
   
-  if (this->i2s_audio_ == nullptr) {
-    ESP_LOGE(TAG, "I2S Audio component not set!");
+  // Without an explicit source, read the I2S port of the audio component
+  if (this->audio_source_ == nullptr) {
+#ifdef ESP_PLATFORM
+    if (this->i2s_audio_ == nullptr) {
+      ESP_LOGE(TAG, "I2S Audio component not set!");
+      this->mark_failed();
+      return;
+    }
+    this->audio_source_ = new I2SAudioSource(this->i2s_audio_->get_port());
+#else
+    // Host builds (tests, replay) have no I2S
+    ESP_LOGE(TAG, "No audio source set!");
+    this->mark_failed();
+    return;
+#endif
+  }
+  
+  if (!FFTPlan::is_supported_size(this->fft_size_) || this->fft_size_ < 4) {
+    ESP_LOGE(TAG, "FFT size %d is not supported, it must be even", this->fft_size_);
+    this->mark_failed();
+    return;
+  }
+  // Only the float path has mixed-radix and Bluestein transforms
+  if (this->precision_ != PRECISION_FLOAT && !FFTPlan::is_power_of_two_size(this->fft_size_)) {
+    ESP_LOGE(TAG, "FFT size %d is not a power of two, as fixed-point precision requires", this->fft_size_);
+    this->mark_failed();
+    return;
+  }
+  
+  // Overlapping frames are cut from a ring buffer every hop_size samples
+  if (this->hop_size_ <= 0 || this->hop_size_ > this->fft_size_) {
+    this->hop_size_ = this->fft_size_;
+  }
+  
+  if (this->channels_ < 1 || (this->channels_ > 1 && this->precision_ != PRECISION_FLOAT)) {
+    ESP_LOGE(TAG, "%d channels are not supported at this precision", this->channels_);
+    this->mark_failed();
+    return;
+  }
+  
+  // Zoom mode trades the full band for finer bins around one frequency; its
+  // bins are not on the 0 Hz to Nyquist grid that bands are laid out on
+  const bool use_zoom = this->zoom_decimation_ > 1;
+  if (use_zoom && (!this->band_sensors_.empty() || this->channels_ > 1)) {
+    ESP_LOGE(TAG, "Zoom mode supports neither band sensors nor several channels");
+    this->mark_failed();
+    return;
+  }
+  
+  // Extra resolutions run beside the main one on the float samples of channel 0
+  const bool use_resolutions = !this->resolutions_.empty();
+  if (use_resolutions &&
+      (this->precision_ != PRECISION_FLOAT || this->channels_ > 1 || this->pipelined_ || use_zoom)) {
+    ESP_LOGE(TAG, "Several resolutions need float precision, one channel and neither zoom nor pipelining");
+    this->mark_failed();
+    return;
+  }
+  
+  // Sparse mode watches a few target frequencies, through streaming Goertzel
+  // filters when they cost less than the FFT (which bands always need), or
+  // through a sliding DFT when every sample must count
+  bool use_goertzel = false;
+  const bool use_sliding = !this->targets_.empty() && this->sparse_engine_ == SPARSE_ENGINE_SLIDING_DFT;
+  if (!this->targets_.empty()) {
+    use_goertzel = this->sparse_engine_ == SPARSE_ENGINE_GOERTZEL ||
+                   (this->sparse_engine_ == SPARSE_ENGINE_AUTO && this->band_sensors_.empty() && !use_zoom &&
+                    !use_resolutions && GoertzelBank::is_cheaper_than_fft(this->targets_.size(), this->fft_size_));
+    if ((use_goertzel || use_sliding) && (!this->band_sensors_.empty() || use_zoom || use_resolutions)) {
+      ESP_LOGE(TAG, "Band sensors, zoom and several resolutions need the FFT engine");
+      this->mark_failed();
+      return;
+    }
+  }
+  std::vector<float> frequencies;
+  for (const Target &target : this->targets_) {
+    frequencies.push_back(target.frequency);
+  }
+  
+  // The main resolution first, so its spectrum is resolution 0
+  std::vector<AnalysisResolution> analyses;
+  if (use_resolutions) {
+    analyses.push_back({(size_t) this->fft_size_, (size_t) this->hop_size_});
+    analyses.insert(analyses.end(), this->resolutions_.begin(), this->resolutions_.end());
+  }
+  
+  const char *engine;
+  if (use_goertzel) {
+    // No frame buffer and no tables beyond one coefficient per target
+    this->goertzel_ = new GoertzelBank(this->sample_rate_, this->fft_size_, this->hop_size_, frequencies);
+    engine = "goertzel";
+  } else if (use_sliding) {
+    // A window of fft_size samples, slid one sample at a time
+    this->sliding_ = new SlidingDFT(this->sample_rate_, this->fft_size_, frequencies, this->sliding_damping_);
+    if (!this->sliding_->is_valid()) {
+      ESP_LOGE(TAG, "Invalid sliding DFT damping %.6f", this->sliding_damping_);
+      this->mark_failed();
+      return;
+    }
+    engine = "sliding_dft";
+  } else if (use_zoom) {
+    // A complex FFT of half the size keeps the fft_size/2 bins of the real
+    // one, and half the hop keeps the frame overlap
+    if (!FFTPlan::is_supported_size(this->fft_size_ / 2)) {
+      ESP_LOGE(TAG, "FFT size %d is not supported with zoom, half of it must be even", this->fft_size_);
+      this->mark_failed();
+      return;
+    }
+    this->zoom_ = new ZoomFFT(this->sample_rate_, this->fft_size_ / 2, std::max(this->hop_size_ / 2, 1),
+                              this->zoom_center_, this->zoom_decimation_);
+    if (!this->zoom_->is_valid()) {
+      ESP_LOGE(TAG, "Zoom decimation %d is not supported, it must be even or 3 or 5", this->zoom_decimation_);
+      this->mark_failed();
+      return;
+    }
+    ESP_LOGD(TAG, "Zoom around %.1f Hz: %.3f Hz bins over %.1f Hz, CIC by %u, %u-tap FIR", this->zoom_center_,
+             this->zoom_->bin_width(), this->zoom_->bin_width() * this->zoom_->size(),
+             (unsigned) this->zoom_->cic_decimation(), (unsigned) this->zoom_->fir_taps());
+    engine = "zoom";
+  } else if (use_resolutions) {
+    // Built on the arena below; plans are shared between equal sizes
+    for (const AnalysisResolution &resolution : this->resolutions_) {
+      if (!FFTPlan::is_supported_size(resolution.size) || resolution.size < 4 || resolution.hop_size == 0 ||
+          resolution.hop_size > resolution.size) {
+        ESP_LOGE(TAG, "Resolution of %u points with hop %u is not supported", (unsigned) resolution.size,
+                 (unsigned) resolution.hop_size);
+        this->mark_failed();
+        return;
+      }
+    }
+    this->static_fft_ = nullptr;
+    engine = "multi_resolution";
+  } else {
+    // Build twiddle, bit-reversal and Hann window tables once, in the sample
+    // format; the framers get their buffers from the arena below
+    switch (this->precision_) {
+      case PRECISION_Q15:
+        this->fft_q15_ = new FixedFFT<int16_t>(this->fft_size_);
+        engine = "q15";
+        break;
+      case PRECISION_Q31:
+        this->fft_q31_ = new FixedFFT<int32_t>(this->fft_size_);
+        engine = "q31";
+        break;
+      default:
+        // The framer de-interleaves, every frame holds one block per channel
+        if (this->channels_ > 1) {
+          this->static_fft_ = nullptr;
+          this->multi_fft_ = new MultiChannelFFT(this->fft_size_, this->channels_);
+          engine = this->multi_fft_->plan().kernel_name();
+          break;
+        }
+        if (this->static_fft_ != nullptr && this->static_fft_->size() == (size_t) this->fft_size_) {
+          // Tables are in flash and work buffers in static storage, nothing to build
+          engine = "static";
+          break;
+        }
+        this->static_fft_ = nullptr;
+        this->plan_ = new FFTPlan(this->fft_size_);
+        engine = this->plan_->kernel_name();
+        break;
+    }
+  }
+  
+  // With the FFT, targets read their nearest bin of channel 0
+  for (Target &target : this->targets_) {
+    int bin;
+    if (this->zoom_ != nullptr) {
+      bin = (int) lroundf((target.frequency - this->zoom_->frequency(0)) / this->zoom_->bin_width());
+      if (bin < 0 || bin >= this->fft_size_ / 2) {
+        ESP_LOGW(TAG, "Target %.1f Hz is outside the zoomed band", target.frequency);
+      }
+    } else {
+      bin = (int) lroundf(target.frequency * this->fft_size_ / this->sample_rate_);
+    }
+    target.bin = std::min(std::max(bin, 0), this->fft_size_ / 2 - 1);
+  }
+  
+  // Bin-to-band weights are only built when some band is actually exposed
+  if (!this->band_sensors_.empty()) {
+    this->bands_ = new BandEngine(this->sample_rate_, this->fft_size_, this->band_scale_, this->band_count_,
+                                  this->band_min_frequency_, this->band_max_frequency_);
+    if (!this->bands_->is_valid()) {
+      ESP_LOGE(TAG, "No bands between %.0f Hz and %.0f Hz", this->band_min_frequency_, this->band_max_frequency_);
+      this->mark_failed();
+      return;
+    }
+    for (const BandSensor &band_sensor : this->band_sensors_) {
+      if (band_sensor.band >= (int) this->bands_->band_count()) {
+        ESP_LOGW(TAG, "Band %d does not exist, the layout has %u bands", band_sensor.band,
+                 (unsigned) this->bands_->band_count());
+      }
+    }
+    ESP_LOGD(TAG, "%u bands from %u weights", (unsigned) this->bands_->band_count(),
+             (unsigned) this->bands_->weight_count());
+  }
+  
+  // Channel 0 is the dominant frequency, then one per band sensor and one per target
+  this->aggregator_ = new PublishAggregator(1 + this->band_sensors_.size() + this->targets_.size(),
+                                            this->publish_mode_, this->publish_frames_, this->publish_interval_);
+  this->aggregator_->set_delta(this->publish_delta_);
+  this->peak_finder_ = new PeakFinder(1);
+  this->peak_finder_->set_format(this->format_);
+  if (this->format_.scale() == SPECTRUM_DB) {
+    // dB bins go negative; only bins sitting on the floor are silent
+    this->peak_finder_->set_threshold(this->format_.floor_db());
+  }
+  
+  if (this->use_gate_) {
+    this->gate_ = new ActivityGate(this->gate_detector_, this->gate_open_db_, this->gate_close_db_, this->gate_hold_,
+                                   this->gate_keepalive_);
+    if (!this->gate_->is_valid()) {
+      ESP_LOGE(TAG, "Activity gate closes at %.1f dBFS, above its opening level of %.1f dBFS", this->gate_close_db_,
+               this->gate_open_db_);
+      this->mark_failed();
+      return;
+    }
+  }
+  
+  // All working buffers come from one arena. Buffers streamed once per hop
+  // (capture queue, framer ring, pipelined snapshots) may go to PSRAM; the ones
+  // the transform loops over stay internal. On the runtime plan path the frame
+  // copy doubles as the real part, as the input is dead once packed, and the
+  // spectrum overwrites the imaginary part it is computed from.
+  const size_t hop_bytes = this->hop_size_ * this->frame_bytes();
+  const size_t window_bytes = this->fft_size_ * this->frame_bytes();
+  const size_t bins_bytes = (this->fft_size_ / 2 + 1) * sizeof(float);
+  const size_t spectrum_size =
+      this->has_target_spectrum() ? this->targets_.size() : this->channels_ * (this->fft_size_ / 2);
+  const bool framed = !this->has_target_spectrum() && this->zoom_ == nullptr && !use_resolutions;
+  MemoryArena &arena = this->arena_;
+  const int input_block = arena.add("input", hop_bytes, MEMORY_INTERNAL);
+  const int capture_block =
+      arena.add("capture", CaptureTask::ring_storage_size(2 * window_bytes), MEMORY_EXTERNAL);
+  const int ring_block = framed ? arena.add("frame_ring", window_bytes, MEMORY_EXTERNAL) : -1;
+  const int frame_block = framed ? arena.add("frame", window_bytes, MEMORY_INTERNAL) : -1;
+  // One ring as long as the largest frame, and a frame, bins and spectrum per resolution
+  const int resolution_ring_block =
+      use_resolutions ? arena.add("frame_ring", MultiResolutionFFT::ring_storage_size(analyses), MEMORY_EXTERNAL)
+                      : -1;
+  const int resolution_frames_block =
+      use_resolutions ? arena.add("frames", MultiResolutionFFT::frame_storage_size(analyses), MEMORY_INTERNAL) : -1;
+  int imag_block = -1;
+  if (this->plan_ != nullptr) {
+    arena.alias("real", frame_block, bins_bytes);
+    imag_block = arena.add("imag", bins_bytes, MEMORY_INTERNAL);
+  }
+  int spectrum_block = -1;
+  if (this->pipelined_) {
+    spectrum_block = arena.add("snapshots", 3 * spectrum_size * sizeof(float), MEMORY_EXTERNAL);
+  } else if (imag_block >= 0) {
+    spectrum_block = arena.alias("spectrum", imag_block, spectrum_size * sizeof(float));
+  } else if (!use_resolutions) {
+    spectrum_block = arena.add("spectrum", spectrum_size * sizeof(float), MEMORY_INTERNAL);
+  }
+  const int targets_block =
+      this->targets_.empty() ? -1 : arena.add("targets", this->targets_.size() * sizeof(float), MEMORY_INTERNAL);
+  const int bands_block =
+      this->bands_ == nullptr ? -1 : arena.add("bands", this->bands_->band_count() * sizeof(float), MEMORY_INTERNAL);
+  const int values_block = arena.add("values", this->aggregator_->channels() * sizeof(float), MEMORY_INTERNAL);
+  // Only written once per published frame, so it can live in PSRAM
+  const size_t history_bins = this->has_target_spectrum() ? this->targets_.size() : this->fft_size_ / 2;
+  int history_block = -1;
+  if (this->history_frames_ > 0) {
+    history_block = arena.add(
+        "history", SpectrogramHistory::storage_size(history_bins, this->history_frames_, this->history_depth_),
+        MEMORY_EXTERNAL);
+  }
+  if (!arena.allocate(this->use_psram_)) {
+    ESP_LOGE(TAG, "Failed to allocate %u bytes of working memory",
+             (unsigned) (arena.bytes(MEMORY_INTERNAL) + arena.bytes(MEMORY_EXTERNAL)));
     this->mark_failed();
     return;
   }
+  if (this->use_psram_ && !arena.is_external()) {
+    ESP_LOGW(TAG, "No PSRAM available, all buffers are in internal RAM");
+  }
+  this->log_memory();
   
-  // Allocate buffers
-  this->input_buffer_ = new float[this->fft_size_];
-  this->fft_output_ = new float[this->fft_size_ / 2];
-  this->window_ = new float[this->fft_size_];
-  this->real_ = new float[this->fft_size_];
-  this->imag_ = new float[this->fft_size_];
+  this->input_buffer_ = arena.get<uint8_t>(input_block);
+  if (framed) {
+    switch (this->precision_) {
+      case PRECISION_Q15:
+        this->framer_q15_ = new StftFramer<int16_t>(this->fft_size_, this->hop_size_, 1,
+                                                    arena.get<int16_t>(ring_block), arena.get<int16_t>(frame_block));
+        break;
+      case PRECISION_Q31:
+        this->framer_q31_ = new StftFramer<int32_t>(this->fft_size_, this->hop_size_, 1,
+                                                    arena.get<int32_t>(ring_block), arena.get<int32_t>(frame_block));
+        break;
+      default:
+        this->framer_ = new StftFramer<float>(this->fft_size_, this->hop_size_, this->channels_,
+                                              arena.get<float>(ring_block), arena.get<float>(frame_block));
+        break;
+    }
+  }
+  if (imag_block >= 0) {
+    this->real_ = arena.get<float>(frame_block);
+    this->imag_ = arena.get<float>(imag_block);
+  }
+  if (use_resolutions) {
+    this->multi_resolution_ = new MultiResolutionFFT(analyses, arena.get<float>(resolution_ring_block),
+                                                     arena.get<float>(resolution_frames_block));
+  }
+  if (this->pipelined_) {
+    this->snapshots_ = new TripleBuffer<float>(spectrum_size, arena.get<float>(spectrum_block));
+    this->fft_output_ = this->snapshots_->write_buffer();
+    this->spectrum_ = this->snapshots_->read_buffer();
+  } else if (this->multi_resolution_ != nullptr) {
+    // The main spectrum stays where the analyser transforms it
+    this->fft_output_ = this->multi_resolution_->spectrum(0);
+    this->spectrum_ = this->fft_output_;
+  } else {
+    this->fft_output_ = arena.get<float>(spectrum_block);
+    this->spectrum_ = this->fft_output_;
+  }
+  if (targets_block >= 0) {
+    this->target_magnitudes_ = arena.get<float>(targets_block);
+  }
+  if (bands_block >= 0) {
+    this->band_energies_ = arena.get<float>(bands_block);
+  }
+  this->frame_values_ = arena.get<float>(values_block);
+  if (history_block >= 0) {
+    this->history_ = new SpectrogramHistory(history_bins, this->history_frames_, this->history_depth_,
+                                            this->history_floor_db_, this->history_range_db_,
+                                            arena.get<uint8_t>(history_block));
+    // Zoom frames come every half hop of decimated samples
+    const float frame_samples = this->zoom_ != nullptr
+                                    ? (float) std::max(this->hop_size_ / 2, 1) * this->zoom_->decimation()
+                                    : (float) this->hop_size_;
+    ESP_LOGD(TAG, "Spectrogram history of %d frames, %.1f s at one frame per hop", this->history_frames_,
+             this->history_frames_ * frame_samples / this->sample_rate_);
+  }
   
-  // Create Hanning window
-  for (int i = 0; i < this->fft_size_; i++) {
-    this->window_[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (this->fft_size_ - 1)));
+  // Start acquisition from the audio source; the queue holds two frames
+  if (!this->audio_source_->open(this->sample_format(), this->sample_rate_, this->channels_)) {
+    ESP_LOGE(TAG, "Failed to open %s audio source", this->audio_source_->name());
+    this->mark_failed();
+    return;
+  }
+  this->capture_ = new CaptureTask(2 * window_bytes, hop_bytes, arena.get<uint8_t>(capture_block));
+  bool started = this->capture_->start(this->audio_source_);
+  if (!started) {
+    ESP_LOGE(TAG, "Failed to start %s capture task", this->audio_source_->name());
+    this->mark_failed();
+    return;
   }
   
-  ESP_LOGD(TAG, "FFT initialized with sample rate %d Hz and FFT size %d", this->sample_rate_, this->fft_size_);
+  if (this->pipelined_) {
+    // Capture stays on core 0, framing and FFT move to core 1
+    this->compute_ = new WorkerTask();
+    started = this->compute_->start(
+        [this]() {
+          if (!this->process_audio())
+            WorkerTask::sleep_ms(1);
+        },
+        "fft_compute", 1, 5, 8192);
+    if (!started) {
+      ESP_LOGE(TAG, "Failed to start FFT compute task");
+      this->mark_failed();
+      return;
+    }
+  }
+  
+#ifndef REALTIME_FFT_NO_INSTRUMENTATION
+  // Stage timing runs on the CPU cycle counter
+  this->stats_ = new PipelineStats(arch_get_cpu_cycle_count, arch_get_cpu_freq_hz());
+  this->last_stats_time_ = millis();
+  this->set_interval("stats", this->stats_interval_, [this]() { this->publish_stats(); });
+#endif
+  
+  ESP_LOGD(TAG, "FFT initialized with sample rate %d Hz, FFT size %d, hop size %d and %d channel(s) (%s kernel%s)",
+           this->sample_rate_, this->fft_size_, this->hop_size_, this->channels_, engine,
+           this->pipelined_ ? ", pipelined" : "");
+}
+
+void RealtimeFFTComponent::log_memory() {
+  const MemoryArena &arena = this->arena_;
+  for (int i = 0; i < (int) arena.block_count(); i++) {
+    const int owner = arena.block_owner(i);
+    if (owner >= 0) {
+      ESP_LOGD(TAG, "  %-10s %7u bytes, shares %s", arena.block_name(i), (unsigned) arena.block_bytes(i),
+               arena.block_name(owner));
+    } else {
+      ESP_LOGD(TAG, "  %-10s %7u bytes, %s", arena.block_name(i), (unsigned) arena.block_bytes(i),
+               arena.block_region(i) == MEMORY_EXTERNAL ? "PSRAM" : "internal");
+    }
+  }
+  // Twiddle, window and bit-reversal tables are owned by the engines
+  size_t tables = 0;
+  if (this->plan_ != nullptr) {
+    tables = this->plan_->memory_bytes();
+  } else if (this->multi_fft_ != nullptr) {
+    tables = this->multi_fft_->memory_bytes();
+  } else if (this->fft_q15_ != nullptr) {
+    tables = this->fft_q15_->memory_bytes();
+  } else if (this->fft_q31_ != nullptr) {
+    tables = this->fft_q31_->memory_bytes();
+  } else if (this->zoom_ != nullptr) {
+    tables = this->zoom_->memory_bytes();
+  } else if (this->multi_resolution_ != nullptr) {
+    tables = this->multi_resolution_->memory_bytes();
+  }
+  ESP_LOGI(TAG, "Working memory: %u bytes internal, %u bytes PSRAM (%u saved by aliasing), plus %u bytes of tables",
+           (unsigned) arena.bytes(MEMORY_INTERNAL), (unsigned) arena.bytes(MEMORY_EXTERNAL),
+           (unsigned) arena.aliased_bytes(), (unsigned) tables);
 }
 
 void RealtimeFFTComponent::loop() {
-  if (this->i2s_audio_ == nullptr) {
+  if (this->capture_ == nullptr) {
     return;
   }
   
-  this->process_audio();
+  if (this->snapshots_ == nullptr) {
+    this->process_audio();
+  } else if (this->snapshots_->update()) {
+    // Only the newest finished frame is published; older ones were superseded
+    ScopedBusy busy(this->stats_);
+    this->spectrum_ = this->snapshots_->read_buffer();
+    this->publish_spectrum();
+    const uint32_t computed = this->frames_computed_.load(std::memory_order_relaxed);
+    if (this->stats_ != nullptr && computed - this->last_computed_ > 1) {
+      this->stats_->add_dropped_frames(computed - this->last_computed_ - 1);
+    }
+    this->last_computed_ = computed;
+  }
+  
+  uint32_t overruns = this->capture_->get_overruns();
+  if (overruns != this->last_overruns_) {
+    ESP_LOGW(TAG, "Capture queue overrun, %u chunks dropped so far", (unsigned) overruns);
+    // Every lost chunk is one hop, i.e. one frame that never gets computed
+    if (this->stats_ != nullptr) {
+      this->stats_->add_dropped_frames(overruns - this->last_overruns_);
+    }
+    this->last_overruns_ = overruns;
+  }
 }
 
-void RealtimeFFTComponent::process_audio() {
-  // Get audio samples from I2S
-  size_t bytes_read;
-  i2s_read(I2S_NUM_0, this->input_buffer_, this->fft_size_ * sizeof(float), &bytes_read, portMAX_DELAY);
+void RealtimeFFTComponent::publish_stats() {
+  const uint32_t now = millis();
+  const float cpu_load = this->stats_->take_cpu_load(now - this->last_stats_time_);
+  this->last_stats_time_ = now;
   
-  // Copy to real buffer and apply window
-  for (int i = 0; i < this->fft_size_; i++) {
-    this->real_[i] = this->input_buffer_[i] * this->window_[i];
-    this->imag_[i] = 0;
+  for (uint8_t s = 0; s < STAGE_COUNT; s++) {
+    const LatencyHistogram &h = this->stats_->stage((Stage) s);
+    ESP_LOGV(TAG, "%-9s n=%u min=%.1fus mean=%.1fus p99=%.1fus max=%.1fus", stage_to_string((Stage) s),
+             (unsigned) h.count(), this->stats_->ticks_to_us(h.min()), this->stats_->ticks_to_us(h.mean()),
+             this->stats_->ticks_to_us(h.percentile(0.99f)), this->stats_->ticks_to_us(h.max()));
   }
   
-  // Perform FFT
-  this->fft(this->real_, this->imag_, this->fft_size_);
-  
-  // Calculate magnitudes
-  for (int i = 0; i < this->fft_size_ / 2; i++) {
-    this->fft_output_[i] = sqrtf(this->real_[i] * this->real_[i] + this->imag_[i] * this->imag_[i]);
+  if (this->cpu_load_sensor_ != nullptr) {
+    this->cpu_load_sensor_->publish_state(cpu_load);
+  }
+  if (this->fft_time_sensor_ != nullptr) {
+    this->fft_time_sensor_->publish_state(this->stats_->ticks_to_us(this->stats_->stage(STAGE_FFT).mean()));
+  }
+  if (this->frame_time_sensor_ != nullptr) {
+    this->frame_time_sensor_->publish_state(
+        this->stats_->ticks_to_us(this->stats_->stage(STAGE_FRAME).percentile(0.99f)));
+  }
+  if (this->overruns_sensor_ != nullptr) {
+    this->overruns_sensor_->publish_state(this->capture_->get_overruns());
+  }
+  if (this->dropped_frames_sensor_ != nullptr) {
+    this->dropped_frames_sensor_->publish_state(this->stats_->dropped_frames());
+  }
+  if (this->gate_ != nullptr) {
+    const uint32_t hops = this->gate_->blocks();
+    ESP_LOGD(TAG, "Activity gate %s at %.1f dBFS, %u of %u hops skipped (%.0f%%), %u keepalive frames",
+             this->gate_->is_open() ? "open" : "closed", this->gate_->level_db(),
+             (unsigned) this->gate_->skipped_blocks(), (unsigned) hops,
+             hops > 0 ? 100.0f * this->gate_->skipped_blocks() / hops : 0.0f,
+             (unsigned) this->gate_->keepalive_blocks());
+    if (this->skipped_frames_sensor_ != nullptr) {
+      this->skipped_frames_sensor_->publish_state(this->gate_->skipped_blocks());
+    }
   }
   
-  // Publish max value
-  float max_value = 0;
-  for (int i = 0; i < this->fft_size_ / 2; i++) {
-    if (this->fft_output_[i] > max_value) {
-      max_value = this->fft_output_[i];
+  // Each report covers the window since the previous one
+  this->stats_->reset_stages();
+}
+
+SampleFormat RealtimeFFTComponent::sample_format() const {
+  switch (this->precision_) {
+    case PRECISION_Q15:
+      return SAMPLE_FORMAT_S16;
+    case PRECISION_Q31:
+      return SAMPLE_FORMAT_S32;
+    default:
+      return SAMPLE_FORMAT_FLOAT32;
+  }
+}
+
+size_t RealtimeFFTComponent::sample_bytes() const { return sample_format_size(this->sample_format()); }
+
+size_t RealtimeFFTComponent::frame_bytes() const { return this->channels_ * this->sample_bytes(); }
+
+bool RealtimeFFTComponent::process_audio() {
+  // Drain whatever complete hops the capture task has queued, never waiting for more
+  ScopedBusy busy(this->stats_);
+  const size_t bytes_read = this->hop_size_ * this->frame_bytes();
+  bool processed = false;
+  while (this->capture_->buffer().available() >= bytes_read) {
+    {
+      ScopedStage stage(this->stats_, STAGE_READ);
+      this->capture_->buffer().pop(this->input_buffer_, bytes_read);
     }
+    this->process_hop(bytes_read);
+    processed = true;
   }
-  this->publish_state(max_value);
+  return processed;
 }
 
-void RealtimeFFTComponent::fft(float *real, float *imag, int n) {
-  int i, j, k, m;
-  float theta, wpr, wpi, wr, wi, tempr, tempi;
+void RealtimeFFTComponent::process_hop(size_t bytes_read) {
+  // The gate measures the raw hop before anything else touches it
+  if (this->gate_ != nullptr && this->gate_hop(bytes_read) == GATE_SKIP) {
+    this->skip_hop(bytes_read);
+    return;
+  }
+  
+  if (this->has_target_spectrum() || this->zoom_ != nullptr) {
+    this->process_hop_streaming(bytes_read);
+    return;
+  }
+  if (this->multi_resolution_ != nullptr) {
+    this->process_hop_resolutions(bytes_read);
+    return;
+  }
   
-  // Bit-reverse
-  j = 0;
-  for (i = 0; i < n - 1; i++) {
-    if (i < j) {
-      tempr = real[j];
-      real[j] = real[i];
-      real[i] = tempr;
-      tempi = imag[j];
-      imag[j] = imag[i];
-      imag[i] = tempi;
+  // Every completed frame is transformed and handed on straight away
+  switch (this->precision_) {
+    case PRECISION_Q15:
+      this->framer_q15_->push(reinterpret_cast<const int16_t *>(this->input_buffer_), bytes_read / sizeof(int16_t),
+                              [this](const int16_t *frame) {
+                                ScopedStage stage(this->stats_, STAGE_FRAME);
+                                {
+                                  ScopedStage fft(this->stats_, STAGE_FFT);
+                                  this->fft_q15_->spectrum(frame, this->fft_output_, this->format_);
+                                }
+                                this->frame_ready();
+                              });
+      break;
+    case PRECISION_Q31:
+      this->framer_q31_->push(reinterpret_cast<const int32_t *>(this->input_buffer_), bytes_read / sizeof(int32_t),
+                              [this](const int32_t *frame) {
+                                ScopedStage stage(this->stats_, STAGE_FRAME);
+                                {
+                                  ScopedStage fft(this->stats_, STAGE_FFT);
+                                  this->fft_q31_->spectrum(frame, this->fft_output_, this->format_);
+                                }
+                                this->frame_ready();
+                              });
+      break;
+    default:
+      this->framer_->push(reinterpret_cast<const float *>(this->input_buffer_), bytes_read / sizeof(float),
+                          [this](const float *frame) { this->process_frame(frame); });
+      break;
+  }
+}
+
+GateAction RealtimeFFTComponent::gate_hop(size_t bytes_read) {
+  switch (this->precision_) {
+    case PRECISION_Q15:
+      return this->gate_->update(reinterpret_cast<const int16_t *>(this->input_buffer_), bytes_read / sizeof(int16_t));
+    case PRECISION_Q31:
+      return this->gate_->update(reinterpret_cast<const int32_t *>(this->input_buffer_), bytes_read / sizeof(int32_t));
+    default:
+      return this->gate_->update(reinterpret_cast<const float *>(this->input_buffer_), bytes_read / sizeof(float));
+  }
+}
+
+void RealtimeFFTComponent::skip_hop(size_t bytes_read) {
+  // Frames falling due are dropped rather than transformed, so the first one
+  // after the gate opens is whole. The streaming engines simply miss the hop;
+  // what they still hold is of the quiet input anyway.
+  if (this->multi_resolution_ != nullptr) {
+    this->multi_resolution_->skip(reinterpret_cast<const float *>(this->input_buffer_), bytes_read / sizeof(float), 1);
+    return;
+  }
+  if (this->has_target_spectrum() || this->zoom_ != nullptr) {
+    return;
+  }
+  switch (this->precision_) {
+    case PRECISION_Q15:
+      this->framer_q15_->push(reinterpret_cast<const int16_t *>(this->input_buffer_), bytes_read / sizeof(int16_t),
+                              [](const int16_t *) {});
+      break;
+    case PRECISION_Q31:
+      this->framer_q31_->push(reinterpret_cast<const int32_t *>(this->input_buffer_), bytes_read / sizeof(int32_t),
+                              [](const int32_t *) {});
+      break;
+    default:
+      this->framer_->push(reinterpret_cast<const float *>(this->input_buffer_), bytes_read / sizeof(float),
+                          [](const float *) {});
+      break;
+  }
+}
+
+template<typename T> size_t RealtimeFFTComponent::push_streaming(const T *samples, size_t count) {
+  if (this->zoom_ != nullptr) {
+    // The newest frame's complex bins go straight into the configured format
+    return this->zoom_->push(samples, count, this->channels_, [this](const float *real, const float *imag) {
+      this->format_.from_complex(real, imag, this->fft_output_, this->zoom_->size());
+    });
+  }
+  if (this->sliding_ != nullptr) {
+    // Every hop is a frame: the largest level reached on any sample of it, so
+    // a burst shorter than the hop still shows
+    std::fill_n(this->fft_output_, this->targets_.size(), 0.0f);
+    this->sliding_->push(samples, count, this->channels_, this->fft_output_);
+    return 1;
+  }
+  return this->goertzel_->push(samples, count, this->channels_, [this](const float *powers) {
+    std::copy_n(powers, this->targets_.size(), this->fft_output_);
+  });
+}
+
+void RealtimeFFTComponent::process_hop_streaming(size_t bytes_read) {
+  // Filters run on channel 0 sample by sample; blocks end on hop boundaries,
+  // zoom frames every half hop of decimated samples
+  size_t blocks;
+  {
+    ScopedStage stage(this->stats_, STAGE_FFT);
+    switch (this->precision_) {
+      case PRECISION_Q15:
+        blocks = this->push_streaming(reinterpret_cast<const int16_t *>(this->input_buffer_),
+                                      bytes_read / sizeof(int16_t));
+        break;
+      case PRECISION_Q31:
+        blocks = this->push_streaming(reinterpret_cast<const int32_t *>(this->input_buffer_),
+                                      bytes_read / sizeof(int32_t));
+        break;
+      default:
+        blocks = this->push_streaming(reinterpret_cast<const float *>(this->input_buffer_),
+                                      bytes_read / sizeof(float));
+        break;
     }
-    k = n / 2;
-    while (k <= j) {
-      j -= k;
-      k /= 2;
+  }
+  if (blocks > 0) {
+    if (this->has_target_spectrum()) {
+      // The filters leave powers; only the newest block is converted
+      ScopedStage magnitude(this->stats_, STAGE_MAGNITUDE);
+      this->format_.from_power(this->fft_output_, this->targets_.size());
     }
-    j += k;
+    this->frame_ready();
+  }
+}
+
+void RealtimeFFTComponent::process_hop_resolutions(size_t bytes_read) {
+  // Each resolution cuts its own frames from the shared ring; the larger
+  // transforms are spread over hops, and only the main one is published
+  bool main_frame = false;
+  {
+    ScopedStage stage(this->stats_, STAGE_FFT);
+    this->multi_resolution_->push(reinterpret_cast<const float *>(this->input_buffer_), bytes_read / sizeof(float), 1,
+                                  this->format_, [&main_frame](size_t resolution, const float *) {
+                                    if (resolution == 0)
+                                      main_frame = true;
+                                  });
+  }
+  const uint32_t dropped = this->multi_resolution_->dropped_frames();
+  if (this->stats_ != nullptr && dropped != this->last_resolution_dropped_) {
+    this->stats_->add_dropped_frames(dropped - this->last_resolution_dropped_);
+  }
+  this->last_resolution_dropped_ = dropped;
+  if (main_frame) {
+    this->frame_ready();
+  }
+}
+
+void RealtimeFFTComponent::process_frame(const float *frame) {
+  ScopedStage stage(this->stats_, STAGE_FRAME);
+  if (this->static_fft_ != nullptr || this->multi_fft_ != nullptr) {
+    {
+      // The spectrum format is fused into the transform here
+      ScopedStage fft(this->stats_, STAGE_FFT);
+      if (this->multi_fft_ != nullptr) {
+        this->multi_fft_->spectrum(frame, this->fft_output_, this->format_);
+      } else {
+        this->static_fft_->spectrum(frame, this->fft_output_, this->format_);
+      }
+    }
+    this->frame_ready();
+    return;
   }
   
-  // Danielson-Lanczos
-  m = 2;
-  while (m <= n) {
-    theta = -2.0f * M_PI / m;
-    wpr = cosf(theta);
-    wpi = sinf(theta);
-    wr = 1.0f;
-    wi = 0.0f;
-    
-    for (j = 0; j < m / 2; j++) {
-      for (i = j; i < n; i += m) {
-        k = i + m / 2;
-        tempr = wr * real[k] - wi * imag[k];
-        tempi = wr * imag[k] + wi * real[k];
-        real[k] = real[i] - tempr;
-        imag[k] = imag[i] - tempi;
-        real[i] += tempr;
-        imag[i] += tempi;
+  {
+    // Window and transform as a real-input FFT (N/2 complex points); the last
+    // pass writes the bins in the configured format
+    ScopedStage fft(this->stats_, STAGE_FFT);
+    this->plan_->forward_spectrum(frame, this->real_, this->imag_, this->fft_output_, this->format_);
+  }
+  
+  this->frame_ready();
+}
+
+void RealtimeFFTComponent::frame_ready() {
+  if (this->snapshots_ == nullptr) {
+    this->publish_spectrum();
+    return;
+  }
+  // Compute task: hand the finished frame to loop() and carry on in a free slot
+  this->frames_computed_.fetch_add(1, std::memory_order_relaxed);
+  this->snapshots_->publish();
+  this->fft_output_ = this->snapshots_->write_buffer();
+}
+
+void RealtimeFFTComponent::publish_spectrum() {
+  ScopedStage stage(this->stats_, STAGE_PUBLISH);
+  if (!this->targets_.empty()) {
+    // Sparse mode: the strongest target, from the filters or its FFT bin
+    size_t best = 0;
+    for (size_t i = 0; i < this->targets_.size(); i++) {
+      const float value = this->has_target_spectrum() ? this->spectrum_[i] : this->spectrum_[this->targets_[i].bin];
+      this->target_magnitudes_[i] = this->format_.to_magnitude(value);
+      if (this->target_magnitudes_[i] > this->target_magnitudes_[best]) {
+        best = i;
       }
-      wr = (tempr = wr) * wpr - wi * wpi;
-      wi = wi * wpr + tempr * wpi;
     }
-    m *= 2;
+    this->dominant_frequency_ = this->target_magnitudes_[best] > 0.0f ? this->targets_[best].frequency : NAN;
+    this->dominant_magnitude_ = this->target_magnitudes_[best];
+  } else if (this->peak_finder_->find(this->spectrum_, this->fft_size_ / 2) > 0) {
+    // Interpolated frequency of the strongest peak
+    const Peak &peak = (*this->peak_finder_)[0];
+    this->dominant_frequency_ = this->bin_frequency(peak.bin);
+    this->dominant_magnitude_ = peak.magnitude;
+  } else {
+    this->dominant_frequency_ = NAN;
+    this->dominant_magnitude_ = 0.0f;
+  }
+  this->frame_values_[0] = this->dominant_frequency_;
+  if (this->history_ != nullptr) {
+    this->history_->append(this->spectrum_, this->format_, millis());
+  }
+  
+  if (this->bands_ != nullptr) {
+    this->bands_->compute(this->spectrum_, this->band_energies_, this->format_);
+    for (size_t i = 0; i < this->band_sensors_.size(); i++) {
+      const int band = this->band_sensors_[i].band;
+      this->frame_values_[1 + i] = band < (int) this->bands_->band_count() ? this->band_energies_[band] : NAN;
+    }
+  }
+  const size_t first_target = 1 + this->band_sensors_.size();
+  for (size_t i = 0; i < this->targets_.size(); i++) {
+    this->frame_values_[first_target + i] = this->target_magnitudes_[i];
+  }
+  
+  // Every frame is accumulated, sensors only see the window result
+  if (!this->aggregator_->add(this->frame_values_, millis())) {
+    return;
+  }
+  
+  float value = this->aggregator_->value(0);
+  if (this->aggregator_->should_publish(0, value)) {
+    this->publish_state(value);
+  }
+  for (size_t i = 0; i < this->band_sensors_.size(); i++) {
+    // Band level in dB; the floor keeps silent bands finite
+    value = 10.0f * log10f(this->aggregator_->value(1 + i) + 1e-20f);
+    if (this->aggregator_->should_publish(1 + i, value)) {
+      this->band_sensors_[i].sensor->publish_state(value);
+    }
+  }
+  for (size_t i = 0; i < this->targets_.size(); i++) {
+    if (this->targets_[i].sensor == nullptr) {
+      continue;
+    }
+    // Target level in dB of magnitude
+    value = 20.0f * log10f(this->aggregator_->value(first_target + i) + 1e-10f);
+    if (this->aggregator_->should_publish(first_target + i, value)) {
+      this->targets_[i].sensor->publish_state(value);
+    }
+  }
+}
+
+float RealtimeFFTComponent::get_band_energy(int band) const {
+  if (this->bands_ != nullptr && band >= 0 && band < (int) this->bands_->band_count()) {
+    return this->band_energies_[band];
   }
+  return 0.0f;
+}
+
+float RealtimeFFTComponent::get_target_magnitude(int target) const {
+  if (this->target_magnitudes_ != nullptr && target >= 0 && target < (int) this->targets_.size()) {
+    return this->target_magnitudes_[target];
+  }
+  return 0.0f;
+}
+
+SpectrumView RealtimeFFTComponent::get_channel_spectrum(int channel) const {
+  if (this->spectrum_ == nullptr || this->has_target_spectrum() || channel < 0 || channel >= this->channels_) {
+    return SpectrumView();
+  }
+  const size_t bins = this->fft_size_ / 2;
+  return SpectrumView(this->spectrum_ + channel * bins, bins);
 }
 
 float RealtimeFFTComponent::get_fft_value(int bin) {
-  if (bin >= 0 && bin < this->fft_size_ / 2) {
-    return this->fft_output_[bin];
+  if (!this->has_target_spectrum() && bin >= 0 && bin < this->fft_size_ / 2) {
+    return this->spectrum_[bin];
   }
   return 0.0f;
 }
 
+float RealtimeFFTComponent::bin_frequency(float bin) const {
+  if (this->zoom_ != nullptr) {
+    return this->zoom_->frequency(bin);
+  }
+  return bin * this->sample_rate_ / this->fft_size_;
+}
+
 float RealtimeFFTComponent::get_frequency(int bin) {
   if (bin >= 0 && bin < this->fft_size_ / 2) {
-    return bin * this->sample_rate_ / this->fft_size_;
+    return this->bin_frequency(bin);
   }
   return 0.0f;
 }
 
 float *RealtimeFFTComponent::get_spectrum_data() {
-  return this->fft_output_;
+  // Stays consistent until the next loop(), even while the compute task runs
+  return this->spectrum_;
+}
+
+int RealtimeFFTComponent::get_resolution_fft_size(int resolution) const {
+  if (resolution == 0) {
+    return this->fft_size_;
+  }
+  if (resolution > 0 && resolution <= (int) this->resolutions_.size()) {
+    return (int) this->resolutions_[resolution - 1].size;
+  }
+  return 0;
+}
+
+float RealtimeFFTComponent::get_resolution_frequency(int resolution, int bin) const {
+  const int size = this->get_resolution_fft_size(resolution);
+  if (bin < 0 || bin >= size / 2) {
+    return 0.0f;
+  }
+  return resolution == 0 ? this->bin_frequency(bin) : bin * (float) this->sample_rate_ / size;
+}
+
+float *RealtimeFFTComponent::get_spectrum_data(int resolution) {
+  if (resolution == 0) {
+    return this->spectrum_;
+  }
+  if (this->multi_resolution_ != nullptr && resolution > 0 &&
+      resolution < (int) this->multi_resolution_->resolution_count()) {
+    return this->multi_resolution_->spectrum(resolution);
+  }
+  return nullptr;
+}
+
+SpectrumView RealtimeFFTComponent::get_resolution_spectrum(int resolution) const {
+  if (resolution == 0) {
+    return this->get_channel_spectrum(0);
+  }
+  if (this->multi_resolution_ != nullptr && resolution > 0 &&
+      resolution < (int) this->multi_resolution_->resolution_count()) {
+    return SpectrumView(this->multi_resolution_->spectrum(resolution),
+                        this->multi_resolution_->size(resolution) / 2);
+  }
+  return SpectrumView();
 }
 
 }  // namespace realtime_fft
@@ -3,12 +3,50 @@
 #include "esphome/core/component.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/i2s_audio/i2s_audio.h"
-#include "driver/i2s.h"
+#include "activity_gate.h"
+#include "audio_source.h"
+#include "band_engine.h"
+#include "capture_task.h"
+#include "fft_plan.h"
+#include "fixed_fft.h"
+#include "goertzel_bank.h"
+#include "memory_arena.h"
+#include "multi_channel_fft.h"
+#include "multi_resolution_fft.h"
+#include "peak_finder.h"
+#include "pipeline_stats.h"
+#include "publish_aggregator.h"
+#include "sliding_dft.h"
+#include "spectrogram_history.h"
+#include "spectrum_view.h"
+#include "static_fft.h"
+#include "stft_framer.h"
+#include "triple_buffer.h"
+#include "worker_task.h"
+#include "zoom_fft.h"
+#include <atomic>
 #include <cmath>
+#include <vector>
 
 namespace esphome {
 namespace realtime_fft {
 
+// Sample format read from I2S and arithmetic used for the transform
+enum Precision : uint8_t {
+  PRECISION_FLOAT = 0,
+  PRECISION_Q15,
+  PRECISION_Q31,
+};
+
+// How sparse mode evaluates its target frequencies
+enum SparseEngine : uint8_t {
+  SPARSE_ENGINE_AUTO = 0,
+  SPARSE_ENGINE_GOERTZEL,
+  SPARSE_ENGINE_FFT,
+  // Updated on every sample for the lowest latency, never picked by auto
+  SPARSE_ENGINE_SLIDING_DFT,
+};
+
 class RealtimeFFTComponent : public Component, public sensor::Sensor {
  public:
   void setup() override;
@@ -16,27 +54,279 @@ class RealtimeFFTComponent : public Component, public sensor::Sensor {
   
   void set_sample_rate(int sample_rate) { this->sample_rate_ = sample_rate; }
   void set_fft_size(int fft_size) { this->fft_size_ = fft_size; }
+  void set_hop_size(int hop_size) { this->hop_size_ = hop_size; }
+  // Interleaved input channels, all transformed every frame; float precision only
+  void set_channels(int channels) { this->channels_ = channels; }
+  void set_precision(Precision precision) { this->precision_ = precision; }
+  // Compile-time specialised transform generated for the YAML fft_size
+  void set_static_fft(StaticFFTBase *static_fft) { this->static_fft_ = static_fft; }
+  // Run the transform in its own task on the second core; loop() only publishes
+  void set_pipelined(bool pipelined) { this->pipelined_ = pipelined; }
+  // Put the capture queue, framer ring and snapshots in PSRAM when there is some
+  void set_use_psram(bool use_psram) { this->use_psram_ = use_psram; }
+  // What spectrum bins hold; the engines write them in this scale directly
+  void set_spectrum_format(SpectrumScale scale, float reference, float floor_db) {
+    this->format_ = SpectrumFormat(scale, reference, floor_db);
+  }
+  // Keep the last frames published spectra (channel 0, or the targets in
+  // sparse mode) quantised to dB, stamped with millis()
+  void set_history(int frames, HistoryDepth depth, float floor_db, float range_db) {
+    this->history_frames_ = frames;
+    this->history_depth_ = depth;
+    this->history_floor_db_ = floor_db;
+    this->history_range_db_ = range_db;
+  }
+  // Another analysis of channel 0 at its own size and hop, cut from the same
+  // input ring as the main one; float precision, one channel, not pipelined
+  void add_resolution(int fft_size, int hop_size) {
+    this->resolutions_.push_back({(size_t) fft_size, (size_t) hop_size});
+  }
+  // Zoom mode: the fft_size/2 bins span sample_rate / decimation around
+  // center_frequency instead of 0 Hz to Nyquist; one channel only
+  void set_zoom(float center_frequency, int decimation) {
+    this->zoom_center_ = center_frequency;
+    this->zoom_decimation_ = decimation;
+  }
+  // Hops whose level (dBFS, all channels) stays quiet are neither transformed
+  // nor published: the gate opens at open_db, and closes after hold_hops hops
+  // below close_db; while closed, every keepalive_hops-th hop passes (0 = none)
+  void set_activity_gate(GateDetector detector, float open_db, float close_db, uint32_t hold_hops,
+                         uint32_t keepalive_hops) {
+    this->use_gate_ = true;
+    this->gate_detector_ = detector;
+    this->gate_open_db_ = open_db;
+    this->gate_close_db_ = close_db;
+    this->gate_hold_ = hold_hops;
+    this->gate_keepalive_ = keepalive_hops;
+  }
+  // Band layout for the band sensors; band_count only applies to mel and log scales
+  void set_band_layout(BandScale scale, int band_count, float min_frequency, float max_frequency) {
+    this->band_scale_ = scale;
+    this->band_count_ = band_count;
+    this->band_min_frequency_ = min_frequency;
+    this->band_max_frequency_ = max_frequency;
+  }
+  void add_band_sensor(int band, sensor::Sensor *band_sensor) {
+    this->band_sensors_.push_back({band, band_sensor});
+  }
+  // Sparse mode: only these frequencies are evaluated, and the main sensor
+  // reports the strongest of them; target_sensor (optional) gets its level in dB
+  void add_target(float frequency, sensor::Sensor *target_sensor) {
+    this->targets_.push_back({frequency, target_sensor, 0});
+  }
+  void set_sparse_engine(SparseEngine engine) { this->sparse_engine_ = engine; }
+  // Pole radius of the sliding DFT, just below 1 to keep it stable
+  void set_sliding_damping(float damping) { this->sliding_damping_ = damping; }
+  // Sensors get one value per window of frames or milliseconds (0 = no limit;
+  // both 0 = every frame), and only when it moved by more than delta
+  void set_publish_window(AggregateMode mode, uint32_t frames, uint32_t interval_ms) {
+    this->publish_mode_ = mode;
+    this->publish_frames_ = frames;
+    this->publish_interval_ = interval_ms;
+  }
+  void set_publish_delta(float delta) { this->publish_delta_ = delta; }
   void set_i2s_audio_id(i2s_audio::I2SAudioComponent *i2s_audio) { this->i2s_audio_ = i2s_audio; }
+  // Diagnostics, reported every stats interval; ignored with REALTIME_FFT_NO_INSTRUMENTATION
+  void set_stats_interval(uint32_t interval_ms) { this->stats_interval_ = interval_ms; }
+  void set_cpu_load_sensor(sensor::Sensor *cpu_load_sensor) { this->cpu_load_sensor_ = cpu_load_sensor; }
+  void set_fft_time_sensor(sensor::Sensor *fft_time_sensor) { this->fft_time_sensor_ = fft_time_sensor; }
+  void set_frame_time_sensor(sensor::Sensor *frame_time_sensor) { this->frame_time_sensor_ = frame_time_sensor; }
+  void set_overruns_sensor(sensor::Sensor *overruns_sensor) { this->overruns_sensor_ = overruns_sensor; }
+  void set_dropped_frames_sensor(sensor::Sensor *dropped_frames_sensor) {
+    this->dropped_frames_sensor_ = dropped_frames_sensor;
+  }
+  // Hops the activity gate kept from the FFT, one frame each on the main path
+  void set_skipped_frames_sensor(sensor::Sensor *skipped_frames_sensor) {
+    this->skipped_frames_sensor_ = skipped_frames_sensor;
+  }
+  // Replaces I2S as the input, e.g. with a synthetic test signal
+  void set_audio_source(AudioSource *audio_source) { this->audio_source_ = audio_source; }
+  
+  uint32_t get_overruns() const { return this->capture_ != nullptr ? this->capture_->get_overruns() : 0; }
+  // Per-stage latency histograms and loss counters, nullptr without instrumentation
+  const PipelineStats *get_stats() const { return this->stats_; }
+  // Gate state, level and skipped-hop counters, nullptr without a gate
+  const ActivityGate *get_activity_gate() const { return this->gate_; }
+  
+  // Interpolated frequency and magnitude of the strongest peak in the last published spectrum
+  float get_dominant_frequency() const { return this->dominant_frequency_; }
+  float get_dominant_magnitude() const { return this->dominant_magnitude_; }
+  
+  // Band energies of the last published spectrum, empty without band sensors
+  int get_band_count() const { return this->bands_ != nullptr ? this->bands_->band_count() : 0; }
+  float get_band_energy(int band) const;
   
+  // Magnitudes at the target frequencies of the last published frame, sparse mode only
+  int get_target_count() const { return this->targets_.size(); }
+  float get_target_magnitude(int target) const;
+  
+  // Sensors, peaks and bands follow channel 0; every channel's spectrum is kept
+  int get_channel_count() const { return this->channels_; }
+  SpectrumView get_channel_spectrum(int channel) const;
+  
+  // Bins are in the configured spectrum format (magnitude by default)
   float get_fft_value(int bin);
+  // Centre frequency of a bin, within the zoomed band in zoom mode
   float get_frequency(int bin);
+  // fft_size/2 bins per channel, one block after the other; with the
+  // Goertzel and sliding DFT engines, one value per target instead
+  // (get_fft_value reads 0)
   float *get_spectrum_data();
+  const SpectrumFormat &get_spectrum_format() const { return this->format_; }
+  
+  // Resolution 0 is the main fft_size, then one per add_resolution(); each
+  // spectrum holds fft_size/2 bins of channel 0 and changes with its own hop
+  int get_resolution_count() const { return 1 + this->resolutions_.size(); }
+  int get_resolution_fft_size(int resolution) const;
+  float get_resolution_frequency(int resolution, int bin) const;
+  float *get_spectrum_data(int resolution);
+  SpectrumView get_resolution_spectrum(int resolution) const;
+  // Spectrogram of the published frames, nullptr unless enabled; query it
+  // from loop() context, e.g. get_history()->slice(millis() - 10000, millis())
+  const SpectrogramHistory *get_history() const { return this->history_; }
   
   float get_setup_priority() const override { return setup_priority::DATA; }
   
  protected:
   int sample_rate_{44100};
   int fft_size_{1024};
+  int hop_size_{0};
+  int channels_{1};
+  Precision precision_{PRECISION_FLOAT};
+  bool pipelined_{false};
+  SpectrumFormat format_;
   i2s_audio::I2SAudioComponent *i2s_audio_{nullptr};
+  AudioSource *audio_source_{nullptr};
   
-  float *input_buffer_{nullptr};
-  float *fft_output_{nullptr};
-  float *window_{nullptr};
+  // Float path: either the compile-time transform or a runtime plan
+  StaticFFTBase *static_fft_{nullptr};
+  FFTPlan *plan_{nullptr};
+  StftFramer<float> *framer_{nullptr};
   float *real_{nullptr};
   float *imag_{nullptr};
+  // Several channels share one plan and are transformed two at a time
+  MultiChannelFFT *multi_fft_{nullptr};
+  
+  // Fixed-point paths, consuming integer I2S samples as they arrive
+  FixedFFT<int16_t> *fft_q15_{nullptr};
+  FixedFFT<int32_t> *fft_q31_{nullptr};
+  StftFramer<int16_t> *framer_q15_{nullptr};
+  StftFramer<int32_t> *framer_q31_{nullptr};
+  
+  // The source is read in its own task; loop() only drains complete hops from its queue
+  CaptureTask *capture_{nullptr};
+  uint32_t last_overruns_{0};
+  
+  // Pipelined mode: the compute task fills snapshot slots that loop() picks up
+  WorkerTask *compute_{nullptr};
+  TripleBuffer<float> *snapshots_{nullptr};
+  
+  // One hop of raw samples in the configured format
+  uint8_t *input_buffer_{nullptr};
+  // Spectrum being computed, and the last complete one seen by loop()
+  float *fft_output_{nullptr};
+  float *spectrum_{nullptr};
+  
+  PeakFinder *peak_finder_{nullptr};
+  
+  // Sparse mode: target frequencies and, on the FFT engine, their nearest bin
+  struct Target {
+    float frequency;
+    sensor::Sensor *sensor;
+    int bin;
+  };
+  std::vector<Target> targets_;
+  SparseEngine sparse_engine_{SPARSE_ENGINE_AUTO};
+  GoertzelBank *goertzel_{nullptr};
+  SlidingDFT *sliding_{nullptr};
+  float sliding_damping_{0.99999f};
+  float *target_magnitudes_{nullptr};
+  
+  // Extra resolutions; the main one then runs through the same analyser
+  std::vector<AnalysisResolution> resolutions_;
+  MultiResolutionFFT *multi_resolution_{nullptr};
+  uint32_t last_resolution_dropped_{0};
+  
+  // Zoom mode: mixer, decimation and a complex FFT of fft_size/2 points
+  ZoomFFT *zoom_{nullptr};
+  float zoom_center_{0.0f};
+  int zoom_decimation_{0};
+  
+  // Spectrum reduced to bands, each optionally exposed as its own sensor
+  struct BandSensor {
+    int band;
+    sensor::Sensor *sensor;
+  };
+  BandScale band_scale_{BAND_SCALE_THIRD_OCTAVE};
+  int band_count_{16};
+  float band_min_frequency_{20.0f};
+  float band_max_frequency_{20000.0f};
+  std::vector<BandSensor> band_sensors_;
+  BandEngine *bands_{nullptr};
+  float *band_energies_{nullptr};
+  
+  AggregateMode publish_mode_{AGGREGATE_MEAN};
+  uint32_t publish_frames_{0};
+  uint32_t publish_interval_{0};
+  float publish_delta_{0.0f};
+  PublishAggregator *aggregator_{nullptr};
+  float *frame_values_{nullptr};
+  
+  // Every working buffer lives in here; the pointers above point into it
+  MemoryArena arena_;
+  bool use_psram_{false};
+  
+  bool use_gate_{false};
+  GateDetector gate_detector_{GATE_DETECTOR_RMS};
+  float gate_open_db_{-50.0f};
+  float gate_close_db_{-56.0f};
+  uint32_t gate_hold_{0};
+  uint32_t gate_keepalive_{0};
+  ActivityGate *gate_{nullptr};
+  
+  SpectrogramHistory *history_{nullptr};
+  int history_frames_{0};
+  HistoryDepth history_depth_{HISTORY_8BIT};
+  float history_floor_db_{-40.0f};
+  float history_range_db_{120.0f};
+  
+  PipelineStats *stats_{nullptr};
+  uint32_t stats_interval_{10000};
+  uint32_t last_stats_time_{0};
+  // Frames handed over by the compute task, to count the ones loop() never published
+  std::atomic<uint32_t> frames_computed_{0};
+  uint32_t last_computed_{0};
+  sensor::Sensor *cpu_load_sensor_{nullptr};
+  sensor::Sensor *fft_time_sensor_{nullptr};
+  sensor::Sensor *frame_time_sensor_{nullptr};
+  sensor::Sensor *overruns_sensor_{nullptr};
+  sensor::Sensor *dropped_frames_sensor_{nullptr};
+  sensor::Sensor *skipped_frames_sensor_{nullptr};
+  float dominant_frequency_{NAN};
+  float dominant_magnitude_{0.0f};
   
-  void process_audio();
-  void fft(float *real, float *imag, int n);
+  SampleFormat sample_format() const;
+  size_t sample_bytes() const;
+  // One sample of every channel
+  size_t frame_bytes() const;
+  bool process_audio();
+  void log_memory();
+  void process_hop(size_t bytes_read);
+  GateAction gate_hop(size_t bytes_read);
+  // Keeps the frame rings current through a gated hop without transforming
+  void skip_hop(size_t bytes_read);
+  // Engines fed sample by sample rather than by frames: Goertzel, sliding DFT, zoom
+  void process_hop_streaming(size_t bytes_read);
+  template<typename T> size_t push_streaming(const T *samples, size_t count);
+  // True when the spectrum holds one magnitude per target rather than FFT bins
+  bool has_target_spectrum() const { return this->goertzel_ != nullptr || this->sliding_ != nullptr; }
+  void process_hop_resolutions(size_t bytes_read);
+  // Centre frequency of a (fractional) bin of channel 0
+  float bin_frequency(float bin) const;
+  void process_frame(const float *frame);
+  void frame_ready();
+  void publish_spectrum();
+  void publish_stats();
   void apply_window();
 };
 }  // namespace realtime_fft
@@ -1,23 +1,534 @@
+import logging
+import math
+
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import sensor, i2s_audio
-from esphome.const import CONF_ID
+from esphome.const import (
+    CONF_ENGINE,
+    CONF_ID,
+    CONF_SENSOR,
+    CONF_UPDATE_INTERVAL,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_HERTZ,
+    UNIT_MICROSECOND,
+    UNIT_PERCENT,
+)
+
+_LOGGER = logging.getLogger(__name__)
 
 # Définir le namespace du composant
 realtime_fft_ns = cg.esphome_ns.namespace("realtime_fft")
 RealtimeFFTComponent = realtime_fft_ns.class_("RealtimeFFTComponent", cg.Component, sensor.Sensor)
+SyntheticAudioSource = realtime_fft_ns.class_("SyntheticAudioSource")
 
 # Définir les options de configuration
 CONF_SAMPLE_RATE = "sample_rate"
 CONF_FFT_SIZE = "fft_size"
+CONF_HOP_SIZE = "hop_size"
+CONF_CHANNELS = "channels"
+CONF_CHANNEL = "channel"
+CONF_PRECISION = "precision"
+CONF_STATIC_TABLES = "static_tables"
+CONF_PIPELINED = "pipelined"
+CONF_PSRAM = "psram"
+CONF_BANDS = "bands"
+CONF_SCALE = "scale"
+CONF_COUNT = "count"
+CONF_MIN_FREQUENCY = "min_frequency"
+CONF_MAX_FREQUENCY = "max_frequency"
+CONF_SENSORS = "sensors"
+CONF_BAND = "band"
+CONF_PUBLISH = "publish"
+CONF_MODE = "mode"
+CONF_FRAMES = "frames"
+CONF_INTERVAL = "interval"
+CONF_DELTA = "delta"
+CONF_SYNTHETIC = "synthetic"
+CONF_SEED = "seed"
+CONF_TONES = "tones"
+CONF_FREQUENCY = "frequency"
+CONF_AMPLITUDE = "amplitude"
+CONF_CHIRP = "chirp"
+CONF_START_FREQUENCY = "start_frequency"
+CONF_END_FREQUENCY = "end_frequency"
+CONF_DURATION = "duration"
+CONF_WHITE_NOISE = "white_noise"
+CONF_PINK_NOISE = "pink_noise"
+CONF_INSTRUMENTATION = "instrumentation"
+CONF_DIAGNOSTICS = "diagnostics"
+CONF_CPU_LOAD = "cpu_load"
+CONF_FFT_TIME = "fft_time"
+CONF_FRAME_TIME = "frame_time"
+CONF_OVERRUNS = "overruns"
+CONF_DROPPED_FRAMES = "dropped_frames"
+CONF_SPARSE = "sparse"
+CONF_TARGETS = "targets"
+CONF_DAMPING = "damping"
+CONF_SPECTRUM = "spectrum"
+CONF_REFERENCE = "reference"
+CONF_FLOOR = "floor"
+CONF_HISTORY = "history"
+CONF_BITS = "bits"
+CONF_RANGE = "range"
+CONF_ZOOM = "zoom"
+CONF_RESOLUTIONS = "resolutions"
+CONF_GATE = "gate"
+CONF_DETECTOR = "detector"
+CONF_OPEN = "open"
+CONF_CLOSE = "close"
+CONF_HOLD = "hold"
+CONF_KEEPALIVE = "keepalive"
+CONF_SKIPPED_FRAMES = "skipped_frames"
+CONF_CENTER_FREQUENCY = "center_frequency"
+CONF_DECIMATION = "decimation"
 CONF_I2S_AUDIO_ID = "i2s_audio_id"
 
-CONFIG_SCHEMA = sensor.sensor_schema().extend({
+# Format des échantillons I2S et arithmétique de la FFT
+Precision = realtime_fft_ns.enum("Precision")
+PRECISIONS = {
+    "float": Precision.PRECISION_FLOAT,
+    "q15": Precision.PRECISION_Q15,
+    "q31": Precision.PRECISION_Q31,
+}
+
+# Découpage du spectre en bandes
+BandScale = realtime_fft_ns.enum("BandScale")
+BAND_SCALES = {
+    "octave": BandScale.BAND_SCALE_OCTAVE,
+    "third_octave": BandScale.BAND_SCALE_THIRD_OCTAVE,
+    "mel": BandScale.BAND_SCALE_MEL,
+    "log": BandScale.BAND_SCALE_LOG,
+}
+
+# Chaque bande exposée devient un capteur enfant, en dB
+BAND_SENSOR_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement="dB",
+    accuracy_decimals=1,
+    state_class=STATE_CLASS_MEASUREMENT,
+).extend({
+    cv.Required(CONF_BAND): cv.int_range(min=0, max=255),
+})
+
+BANDS_SCHEMA = cv.Schema({
+    cv.Optional(CONF_SCALE, default="third_octave"): cv.enum(BAND_SCALES, lower=True),
+    # Nombre de bandes pour les échelles mel et log
+    cv.Optional(CONF_COUNT, default=16): cv.int_range(min=1, max=64),
+    cv.Optional(CONF_MIN_FREQUENCY, default=20.0): cv.positive_float,
+    cv.Optional(CONF_MAX_FREQUENCY, default=20000.0): cv.positive_float,
+    cv.Required(CONF_SENSORS): cv.ensure_list(BAND_SENSOR_SCHEMA),
+})
+
+# Agrégation des trames entre deux publications
+AggregateMode = realtime_fft_ns.enum("AggregateMode")
+AGGREGATE_MODES = {
+    "mean": AggregateMode.AGGREGATE_MEAN,
+    "max": AggregateMode.AGGREGATE_MAX,
+    "rms": AggregateMode.AGGREGATE_RMS,
+    "last": AggregateMode.AGGREGATE_LAST,
+}
+
+# Sans fenêtre (frames et interval absents), une publication par trame
+PUBLISH_SCHEMA = cv.Schema({
+    cv.Optional(CONF_MODE, default="mean"): cv.enum(AGGREGATE_MODES, lower=True),
+    cv.Optional(CONF_FRAMES): cv.positive_not_null_int,
+    cv.Optional(CONF_INTERVAL): cv.positive_time_period_milliseconds,
+    # Variation minimale avant de republier une valeur
+    cv.Optional(CONF_DELTA, default=0.0): cv.positive_float,
+})
+
+# Contenu des raies du spectre, écrit directement par la dernière passe de la FFT
+SpectrumScale = realtime_fft_ns.enum("SpectrumScale")
+SPECTRUM_SCALES = {
+    "magnitude": SpectrumScale.SPECTRUM_MAGNITUDE,
+    "power": SpectrumScale.SPECTRUM_POWER,
+    "db": SpectrumScale.SPECTRUM_DB,
+}
+
+# power évite toute racine carrée ; db utilise un log2 approché (erreur < 0,003 dB)
+SPECTRUM_SCHEMA = cv.Schema({
+    cv.Optional(CONF_SCALE, default="magnitude"): cv.enum(SPECTRUM_SCALES, lower=True),
+    # Amplitude lue comme 0 dB
+    cv.Optional(CONF_REFERENCE, default=1.0): cv.float_range(min=0.0, min_included=False),
+    # Plancher en dB, les raies silencieuses y restent finies
+    cv.Optional(CONF_FLOOR, default=-120.0): cv.float_range(max=0.0),
+})
+
+# Historique du spectrogramme, quantifié en dB sur 8 bits (échelle fixe) ou 4 bits (échelle par trame)
+HistoryDepth = realtime_fft_ns.enum("HistoryDepth")
+HISTORY_DEPTHS = {
+    8: HistoryDepth.HISTORY_8BIT,
+    4: HistoryDepth.HISTORY_4BIT,
+}
+
+HISTORY_SCHEMA = cv.Schema({
+    # Durée conservée, convertie en nombre de trames d'après hop_size
+    cv.Required(CONF_DURATION): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_BITS, default=8): cv.enum(HISTORY_DEPTHS, int=True),
+    # 8 bits : de floor à floor + range ; 4 bits : range sous le maximum de la trame, jamais sous floor
+    cv.Optional(CONF_FLOOR, default=-40.0): cv.float_,
+    cv.Optional(CONF_RANGE, default=120.0): cv.float_range(min=1.0, max=200.0),
+})
+
+# Résolutions supplémentaires sur le canal 0, découpées dans le même tampon d'entrée ;
+# get_spectrum_data(1) renvoie la première, get_spectrum_data(0) la principale
+RESOLUTION_SCHEMA = cv.Schema({
+    cv.Required(CONF_FFT_SIZE): cv.positive_int,
+    # Par défaut, pas de recouvrement entre les trames
+    cv.Optional(CONF_HOP_SIZE): cv.int_range(min=1),
+})
+
+# Zoom : les fft_size/2 raies couvrent sample_rate / decimation autour de center_frequency
+ZOOM_SCHEMA = cv.Schema({
+    cv.Required(CONF_CENTER_FREQUENCY): cv.positive_float,
+    # Un CIC décime par decimation/4 ou decimation/2, un FIR par le reste ; 3 et 5 passent par le FIR seul
+    cv.Required(CONF_DECIMATION): cv.int_range(min=2, max=1024),
+})
+
+# Porte d'activité : pendant le silence, ni FFT ni publication
+GateDetector = realtime_fft_ns.enum("GateDetector")
+GATE_DETECTORS = {
+    "rms": GateDetector.GATE_DETECTOR_RMS,
+    "peak": GateDetector.GATE_DETECTOR_PEAK,
+}
+
+GATE_SCHEMA = cv.Schema({
+    cv.Optional(CONF_DETECTOR, default="rms"): cv.enum(GATE_DETECTORS, lower=True),
+    # Seuils en dBFS ; sans close, 6 dB d'hystérésis sous open
+    cv.Optional(CONF_OPEN, default=-50.0): cv.float_range(max=0.0),
+    cv.Optional(CONF_CLOSE): cv.float_range(max=0.0),
+    # Durée sous close avant de fermer
+    cv.Optional(CONF_HOLD, default="500ms"): cv.positive_time_period_milliseconds,
+    # Une trame de temps en temps pendant le silence, pour que les capteurs restent à jour
+    cv.Optional(CONF_KEEPALIVE): cv.positive_time_period_milliseconds,
+})
+
+# Mode creux : seules quelques fréquences cibles sont évaluées
+SparseEngine = realtime_fft_ns.enum("SparseEngine")
+SPARSE_ENGINES = {
+    "auto": SparseEngine.SPARSE_ENGINE_AUTO,
+    "goertzel": SparseEngine.SPARSE_ENGINE_GOERTZEL,
+    "fft": SparseEngine.SPARSE_ENGINE_FFT,
+    "sliding_dft": SparseEngine.SPARSE_ENGINE_SLIDING_DFT,
+}
+
+# Le capteur d'une cible reçoit son niveau en dB
+SPARSE_SCHEMA = cv.Schema({
+    cv.Optional(CONF_ENGINE, default="auto"): cv.enum(SPARSE_ENGINES, lower=True),
+    # sliding_dft : rayon du pôle, juste sous 1 ; plus bas = plus stable mais fenêtre plus effilée
+    cv.Optional(CONF_DAMPING, default=0.99999): cv.float_range(min=0.99, max=1.0, max_included=False),
+    cv.Required(CONF_TARGETS): cv.All(cv.ensure_list(cv.Schema({
+        cv.Required(CONF_FREQUENCY): cv.positive_float,
+        cv.Optional(CONF_SENSOR): sensor.sensor_schema(
+            unit_of_measurement="dB",
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+    })), cv.Length(min=1)),
+})
+
+# Signal de test à la place du micro I2S, reproductible grâce à la graine
+SYNTHETIC_SCHEMA = cv.Schema({
+    cv.GenerateID(): cv.declare_id(SyntheticAudioSource),
+    cv.Optional(CONF_SEED, default=1): cv.uint32_t,
+    cv.Optional(CONF_TONES, default=[]): cv.ensure_list(cv.Schema({
+        cv.Required(CONF_FREQUENCY): cv.positive_float,
+        cv.Optional(CONF_AMPLITUDE, default=0.5): cv.zero_to_one_float,
+        # Sans canal, la tonalité est présente sur tous les canaux
+        cv.Optional(CONF_CHANNEL): cv.int_range(min=0, max=7),
+    })),
+    cv.Optional(CONF_CHIRP): cv.Schema({
+        cv.Required(CONF_START_FREQUENCY): cv.positive_float,
+        cv.Required(CONF_END_FREQUENCY): cv.positive_float,
+        cv.Optional(CONF_DURATION, default="1s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_AMPLITUDE, default=0.5): cv.zero_to_one_float,
+    }),
+    cv.Optional(CONF_WHITE_NOISE, default=0.0): cv.zero_to_one_float,
+    cv.Optional(CONF_PINK_NOISE, default=0.0): cv.zero_to_one_float,
+})
+
+# Capteurs de diagnostic : charge CPU, temps FFT moyen, p99 par trame, pertes
+def _timing_sensor():
+    return sensor.sensor_schema(
+        unit_of_measurement=UNIT_MICROSECOND,
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    )
+
+def _counter_sensor():
+    return sensor.sensor_schema(
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_TOTAL_INCREASING,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    )
+
+DIAGNOSTICS_SCHEMA = cv.Schema({
+    cv.Optional(CONF_UPDATE_INTERVAL, default="10s"): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_CPU_LOAD): sensor.sensor_schema(
+        unit_of_measurement=UNIT_PERCENT,
+        accuracy_decimals=1,
+        state_class=STATE_CLASS_MEASUREMENT,
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+    ),
+    cv.Optional(CONF_FFT_TIME): _timing_sensor(),
+    cv.Optional(CONF_FRAME_TIME): _timing_sensor(),
+    cv.Optional(CONF_OVERRUNS): _counter_sensor(),
+    cv.Optional(CONF_DROPPED_FRAMES): _counter_sensor(),
+    # Hops écartés par la porte d'activité
+    cv.Optional(CONF_SKIPPED_FRAMES): _counter_sensor(),
+})
+
+# Tailles pour lesquelles une FFT spécialisée à la compilation (StaticFFT<N>) est générée
+STATIC_FFT_SIZES = [8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096]
+
+def fft_path(fft_size):
+    # Même choix que FFTPlan : la FFT réelle de taille N passe par une FFT complexe de N/2 points
+    if fft_size & (fft_size - 1) == 0:
+        return "radix-4"
+    rest = fft_size // 2
+    for p in (2, 3, 5):
+        while rest % p == 0:
+            rest //= p
+    if rest == 1:
+        return "mixed-radix 2/3/4/5"
+    conv = 1
+    while conv < fft_size - 1:
+        conv *= 2
+    return f"Bluestein ({conv}-point convolution, {fft_size // 2} has factors above 5)"
+
+def validate_fft_size(config):
+    fft_size = config[CONF_FFT_SIZE]
+    if fft_size < 4 or fft_size > 65536 or fft_size % 2 != 0:
+        raise cv.Invalid("fft_size must be even, between 4 and 65536", [CONF_FFT_SIZE])
+    path = fft_path(fft_size)
+    # Les moteurs en virgule fixe n'existent qu'en puissance de deux
+    if path != "radix-4" and config[CONF_PRECISION] != "float":
+        raise cv.Invalid(f"fft_size {fft_size} is not a power of two, which precision "
+                         f"{config[CONF_PRECISION]} requires", [CONF_FFT_SIZE])
+    _LOGGER.info("realtime_fft: fft_size %d uses the %s FFT", fft_size, path)
+    return config
+
+def goertzel_is_cheaper(count, fft_size):
+    # Même modèle de coût que GoertzelBank::is_cheaper_than_fft
+    goertzel = fft_size * (3.0 * count + 6.0)
+    fft = 2.5 * fft_size * math.log2(max(fft_size / 2.0, 2.0)) + 5.0 * fft_size
+    return goertzel < fft
+
+def skips_fft(config):
+    # Même choix que setup() : en auto, Goertzel seulement sans bandes ni zoom et s'il coûte moins ;
+    # goertzel et sliding_dft se passent toujours de la FFT
+    if CONF_SPARSE not in config:
+        return False
+    sparse = config[CONF_SPARSE]
+    if sparse[CONF_ENGINE] == "auto":
+        return (CONF_BANDS not in config and CONF_ZOOM not in config and CONF_RESOLUTIONS not in config
+                and goertzel_is_cheaper(len(sparse[CONF_TARGETS]), config[CONF_FFT_SIZE]))
+    return sparse[CONF_ENGINE] != "fft"
+
+def frame_samples(config):
+    # Échantillons d'entrée entre deux trames ; en zoom, hop_size/2 échantillons décimés
+    if CONF_ZOOM in config:
+        return max(1, config[CONF_HOP_SIZE] // 2) * config[CONF_ZOOM][CONF_DECIMATION]
+    return config[CONF_HOP_SIZE]
+
+def validate_hop_size(config):
+    # Par défaut, pas de recouvrement entre les trames
+    if CONF_HOP_SIZE not in config:
+        config[CONF_HOP_SIZE] = config[CONF_FFT_SIZE]
+    if config[CONF_HOP_SIZE] > config[CONF_FFT_SIZE]:
+        raise cv.Invalid("hop_size must not be larger than fft_size")
+    return config
+
+def validate_source(config):
+    # Il faut une entrée : le bus I2S ou le générateur synthétique
+    if CONF_I2S_AUDIO_ID not in config and CONF_SYNTHETIC not in config:
+        raise cv.Invalid("either i2s_audio_id or synthetic is required")
+    return config
+
+def validate_channels(config):
+    # Les moteurs en virgule fixe ne traitent qu'un seul canal
+    if config[CONF_CHANNELS] > 1 and config[CONF_PRECISION] != "float":
+        raise cv.Invalid("several channels require precision: float", [CONF_CHANNELS])
+    for tone in config.get(CONF_SYNTHETIC, {}).get(CONF_TONES, []):
+        if tone.get(CONF_CHANNEL, 0) >= config[CONF_CHANNELS]:
+            raise cv.Invalid(f"tone channel {tone[CONF_CHANNEL]} is out of range", [CONF_SYNTHETIC, CONF_TONES])
+    return config
+
+def validate_diagnostics(config):
+    # Sans instrumentation il n'y a rien à publier
+    if CONF_DIAGNOSTICS in config and not config[CONF_INSTRUMENTATION]:
+        raise cv.Invalid("diagnostics require instrumentation: true", [CONF_DIAGNOSTICS])
+    return config
+
+def validate_sparse(config):
+    if CONF_SPARSE not in config:
+        return config
+    sparse = config[CONF_SPARSE]
+    for target in sparse[CONF_TARGETS]:
+        if target[CONF_FREQUENCY] >= config[CONF_SAMPLE_RATE] / 2:
+            raise cv.Invalid(f"target frequency {target[CONF_FREQUENCY]} Hz is above the Nyquist frequency",
+                             [CONF_SPARSE, CONF_TARGETS])
+    # Les bandes ont besoin du spectre complet
+    if sparse[CONF_ENGINE] in ("goertzel", "sliding_dft") and CONF_BANDS in config:
+        raise cv.Invalid("bands need the FFT, use engine: fft or auto", [CONF_SPARSE, CONF_ENGINE])
+    if sparse[CONF_ENGINE] == "sliding_dft":
+        # Une valeur par hop : c'est hop_size qui fixe la latence, pas fft_size
+        _LOGGER.info("realtime_fft: %d target(s), sliding DFT engine, %.1f ms per update",
+                     len(sparse[CONF_TARGETS]), 1000.0 * config[CONF_HOP_SIZE] / config[CONF_SAMPLE_RATE])
+    else:
+        _LOGGER.info("realtime_fft: %d target(s), %s engine", len(sparse[CONF_TARGETS]),
+                     "Goertzel" if skips_fft(config) else "FFT")
+    return config
+
+def history_frames(config):
+    # Une trame par hop ; arrondi vers le haut pour couvrir toute la durée
+    history = config[CONF_HISTORY]
+    hop_ms = 1000.0 * frame_samples(config) / config[CONF_SAMPLE_RATE]
+    return max(1, math.ceil(history[CONF_DURATION].total_milliseconds / hop_ms))
+
+def validate_history(config):
+    if CONF_HISTORY not in config:
+        return config
+    frames = history_frames(config)
+    bins = len(config[CONF_SPARSE][CONF_TARGETS]) if skips_fft(config) else config[CONF_FFT_SIZE] // 2
+    row = bins if config[CONF_HISTORY][CONF_BITS] == 8 else (bins + 1) // 2 + 8
+    _LOGGER.info("realtime_fft: spectrogram history of %d frames, %d bytes", frames, frames * (row + 4))
+    return config
+
+def validate_zoom(config):
+    if CONF_ZOOM not in config:
+        return config
+    zoom = config[CONF_ZOOM]
+    # La FFT complexe du zoom a fft_size/2 points, qui doivent former une taille prise en charge
+    half = config[CONF_FFT_SIZE] // 2
+    if half % 2 != 0 and half & (half - 1) != 0:
+        raise cv.Invalid(f"zoom needs half of fft_size to be even, {half} is odd", [CONF_FFT_SIZE])
+    decimation = zoom[CONF_DECIMATION]
+    # Même découpage que ZoomFFT : le CIC décime au plus par 256
+    if decimation % 2 != 0 and decimation not in (3, 5):
+        raise cv.Invalid("decimation must be even, or 3 or 5", [CONF_ZOOM, CONF_DECIMATION])
+    if decimation % 4 == 2 and decimation > 512:
+        raise cv.Invalid("decimation above 512 must be a multiple of 4", [CONF_ZOOM, CONF_DECIMATION])
+    span = config[CONF_SAMPLE_RATE] / decimation
+    low = zoom[CONF_CENTER_FREQUENCY] - span / 2
+    high = zoom[CONF_CENTER_FREQUENCY] + span / 2
+    if low < 0 or high > config[CONF_SAMPLE_RATE] / 2:
+        raise cv.Invalid(f"the zoomed band {low:.1f} Hz to {high:.1f} Hz must lie between 0 Hz and the "
+                         f"Nyquist frequency", [CONF_ZOOM])
+    # Les raies ne couvrent plus 0 Hz - Nyquist, sur lesquels les bandes sont placées
+    if CONF_BANDS in config:
+        raise cv.Invalid("bands are not available with zoom", [CONF_ZOOM])
+    if config[CONF_CHANNELS] > 1:
+        raise cv.Invalid("zoom analyses a single channel", [CONF_ZOOM])
+    if CONF_SPARSE in config and config[CONF_SPARSE][CONF_ENGINE] in ("goertzel", "sliding_dft"):
+        raise cv.Invalid("zoomed targets need the FFT, use engine: fft or auto", [CONF_SPARSE, CONF_ENGINE])
+    # Les 10 % extérieurs de chaque côté peuvent recevoir du repliement
+    _LOGGER.info("realtime_fft: zoom over %.1f Hz to %.1f Hz, %.3f Hz per bin, %.1f ms per frame",
+                 low, high, span / (config[CONF_FFT_SIZE] // 2),
+                 1000.0 * frame_samples(config) / config[CONF_SAMPLE_RATE])
+    return config
+
+def validate_resolutions(config):
+    if CONF_RESOLUTIONS not in config:
+        return config
+    # Même restrictions que setup() : une seule entrée flottante, lue dans loop()
+    if config[CONF_PRECISION] != "float" or config[CONF_CHANNELS] > 1 or config[CONF_PIPELINED]:
+        raise cv.Invalid("resolutions require precision: float, a single channel and pipelined: false",
+                         [CONF_RESOLUTIONS])
+    if CONF_ZOOM in config:
+        raise cv.Invalid("resolutions are not available with zoom", [CONF_RESOLUTIONS])
+    if CONF_SPARSE in config and config[CONF_SPARSE][CONF_ENGINE] in ("goertzel", "sliding_dft"):
+        raise cv.Invalid("resolutions need the FFT, use engine: fft or auto", [CONF_SPARSE, CONF_ENGINE])
+    smallest = min([config[CONF_FFT_SIZE]] + [r[CONF_FFT_SIZE] for r in config[CONF_RESOLUTIONS]])
+    for i, resolution in enumerate(config[CONF_RESOLUTIONS]):
+        fft_size = resolution[CONF_FFT_SIZE]
+        if fft_size < 4 or fft_size > 65536 or fft_size % 2 != 0:
+            raise cv.Invalid("fft_size must be even, between 4 and 65536", [CONF_RESOLUTIONS, i, CONF_FFT_SIZE])
+        if CONF_HOP_SIZE not in resolution:
+            resolution[CONF_HOP_SIZE] = fft_size
+        if resolution[CONF_HOP_SIZE] > fft_size:
+            raise cv.Invalid("hop_size must not be larger than fft_size", [CONF_RESOLUTIONS, i, CONF_HOP_SIZE])
+        # Les grandes FFT attendent leur tour d'un hop à l'autre ; un hop plus court que
+        # celui de la résolution principale remplacerait des trames en attente
+        if fft_size > smallest and resolution[CONF_HOP_SIZE] < config[CONF_HOP_SIZE]:
+            raise cv.Invalid(f"hop_size must be at least the main hop_size {config[CONF_HOP_SIZE]}",
+                             [CONF_RESOLUTIONS, i, CONF_HOP_SIZE])
+        _LOGGER.info("realtime_fft: resolution %d, fft_size %d (%s FFT), %.2f Hz per bin, %.1f ms per frame",
+                     i + 1, fft_size, fft_path(fft_size), config[CONF_SAMPLE_RATE] / fft_size,
+                     1000.0 * resolution[CONF_HOP_SIZE] / config[CONF_SAMPLE_RATE])
+    return config
+
+def gate_hops(config, key):
+    # hold et keepalive comptés en hops, l'unité de décision de la porte
+    hop_ms = 1000.0 * config[CONF_HOP_SIZE] / config[CONF_SAMPLE_RATE]
+    if key not in config[CONF_GATE]:
+        return 0
+    return max(1, math.ceil(config[CONF_GATE][key].total_milliseconds / hop_ms))
+
+def validate_gate(config):
+    if CONF_GATE not in config:
+        if CONF_SKIPPED_FRAMES in config.get(CONF_DIAGNOSTICS, {}):
+            raise cv.Invalid("skipped_frames requires gate", [CONF_DIAGNOSTICS, CONF_SKIPPED_FRAMES])
+        return config
+    gate = config[CONF_GATE]
+    if CONF_CLOSE not in gate:
+        gate[CONF_CLOSE] = gate[CONF_OPEN] - 6.0
+    if gate[CONF_CLOSE] > gate[CONF_OPEN]:
+        raise cv.Invalid("close must not be above open", [CONF_GATE, CONF_CLOSE])
+    keepalive = gate_hops(config, CONF_KEEPALIVE)
+    _LOGGER.info("realtime_fft: activity gate opens at %.1f dBFS, closes %d hops under %.1f dBFS%s",
+                 gate[CONF_OPEN], gate_hops(config, CONF_HOLD), gate[CONF_CLOSE],
+                 f", keepalive every {keepalive} hops" if keepalive else "")
+    return config
+
+def validate_bands(config):
+    if CONF_BANDS not in config:
+        return config
+    bands = config[CONF_BANDS]
+    if bands[CONF_MIN_FREQUENCY] >= bands[CONF_MAX_FREQUENCY]:
+        raise cv.Invalid("min_frequency must be below max_frequency", [CONF_BANDS])
+    # Pour mel et log le nombre de bandes est connu ici ; les octaves sont vérifiées au démarrage
+    if bands[CONF_SCALE] in ("mel", "log"):
+        for conf in bands[CONF_SENSORS]:
+            if conf[CONF_BAND] >= bands[CONF_COUNT]:
+                raise cv.Invalid(f"band {conf[CONF_BAND]} is out of range, count is {bands[CONF_COUNT]}",
+                                 [CONF_BANDS, CONF_SENSORS])
+    return config
+
+CONFIG_SCHEMA = cv.All(sensor.sensor_schema(
+    unit_of_measurement=UNIT_HERTZ,
+    accuracy_decimals=1,
+    state_class=STATE_CLASS_MEASUREMENT,
+).extend({
     cv.GenerateID(): cv.declare_id(RealtimeFFTComponent),
-    cv.Required(CONF_I2S_AUDIO_ID): cv.use_id(i2s_audio.I2SAudioComponent),
+    cv.Optional(CONF_I2S_AUDIO_ID): cv.use_id(i2s_audio.I2SAudioComponent),
+    cv.Optional(CONF_SYNTHETIC): SYNTHETIC_SCHEMA,
     cv.Optional(CONF_SAMPLE_RATE, default=44100): cv.positive_int,
     cv.Optional(CONF_FFT_SIZE, default=1024): cv.positive_int,
-}).extend(cv.COMPONENT_SCHEMA)
+    cv.Optional(CONF_HOP_SIZE): cv.int_range(min=1),
+    # Canaux entrelacés (micro stéréo, réseau de micros), tous analysés à chaque trame
+    cv.Optional(CONF_CHANNELS, default=1): cv.int_range(min=1, max=8),
+    cv.Optional(CONF_PRECISION, default="float"): cv.enum(PRECISIONS, lower=True),
+    cv.Optional(CONF_STATIC_TABLES, default=True): cv.boolean,
+    cv.Optional(CONF_PIPELINED, default=False): cv.boolean,
+    # Tampons volumineux en PSRAM, tables et tampons de calcul en RAM interne
+    cv.Optional(CONF_PSRAM, default=False): cv.boolean,
+    cv.Optional(CONF_BANDS): BANDS_SCHEMA,
+    cv.Optional(CONF_SPARSE): SPARSE_SCHEMA,
+    cv.Optional(CONF_PUBLISH): PUBLISH_SCHEMA,
+    cv.Optional(CONF_SPECTRUM): SPECTRUM_SCHEMA,
+    cv.Optional(CONF_HISTORY): HISTORY_SCHEMA,
+    cv.Optional(CONF_ZOOM): ZOOM_SCHEMA,
+    cv.Optional(CONF_GATE): GATE_SCHEMA,
+    cv.Optional(CONF_RESOLUTIONS): cv.All(cv.ensure_list(RESOLUTION_SCHEMA), cv.Length(min=1, max=4)),
+    cv.Optional(CONF_INSTRUMENTATION, default=True): cv.boolean,
+    cv.Optional(CONF_DIAGNOSTICS): DIAGNOSTICS_SCHEMA,
+}).extend(cv.COMPONENT_SCHEMA), validate_fft_size, validate_hop_size, validate_source, validate_channels,
+          validate_bands, validate_zoom, validate_resolutions, validate_sparse, validate_history, validate_gate,
+          validate_diagnostics)
 
 # Fonction de génération du code C++
 async def to_code(config):
@@ -25,10 +536,103 @@ async def to_code(config):
     await cg.register_component(var, config)
     await sensor.register_sensor(var, config)
     
-    i2s_audio_var = await cg.get_variable(config[CONF_I2S_AUDIO_ID])
-    cg.add(var.set_i2s_audio_id(i2s_audio_var))
+    if CONF_I2S_AUDIO_ID in config:
+        i2s_audio_var = await cg.get_variable(config[CONF_I2S_AUDIO_ID])
+        cg.add(var.set_i2s_audio_id(i2s_audio_var))
     cg.add(var.set_sample_rate(config[CONF_SAMPLE_RATE]))
     cg.add(var.set_fft_size(config[CONF_FFT_SIZE]))
+    cg.add(var.set_hop_size(config[CONF_HOP_SIZE]))
+    cg.add(var.set_channels(config[CONF_CHANNELS]))
+    cg.add(var.set_precision(config[CONF_PRECISION]))
+    # FFT dans une tâche sur le second cœur, loop() ne fait que publier
+    cg.add(var.set_pipelined(config[CONF_PIPELINED]))
+    cg.add(var.set_use_psram(config[CONF_PSRAM]))
+    if CONF_SPECTRUM in config:
+        spectrum = config[CONF_SPECTRUM]
+        cg.add(var.set_spectrum_format(spectrum[CONF_SCALE], spectrum[CONF_REFERENCE], spectrum[CONF_FLOOR]))
+    # Stocké en PSRAM si psram: true, écrit une fois par trame publiée
+    if CONF_HISTORY in config:
+        history = config[CONF_HISTORY]
+        cg.add(var.set_history(history_frames(config), history[CONF_BITS], history[CONF_FLOOR], history[CONF_RANGE]))
+    # Mélange, décimation CIC et FIR, puis FFT complexe de fft_size/2 points
+    if CONF_ZOOM in config:
+        zoom = config[CONF_ZOOM]
+        cg.add(var.set_zoom(zoom[CONF_CENTER_FREQUENCY], zoom[CONF_DECIMATION]))
+    # Mesure du niveau sur chaque hop brut, avant tout fenêtrage
+    if CONF_GATE in config:
+        gate = config[CONF_GATE]
+        cg.add(var.set_activity_gate(gate[CONF_DETECTOR], gate[CONF_OPEN], gate[CONF_CLOSE],
+                                     gate_hops(config, CONF_HOLD), gate_hops(config, CONF_KEEPALIVE)))
+    # Un seul tampon d'entrée et un plan par taille, partagés par toutes les résolutions
+    for resolution in config.get(CONF_RESOLUTIONS, []):
+        cg.add(var.add_resolution(resolution[CONF_FFT_SIZE], resolution[CONF_HOP_SIZE]))
+
+    # Le générateur remplace l'I2S comme entrée de la chaîne
+    if CONF_SYNTHETIC in config:
+        synthetic = config[CONF_SYNTHETIC]
+        source = cg.new_Pvariable(synthetic[CONF_ID], synthetic[CONF_SEED])
+        for tone in synthetic[CONF_TONES]:
+            cg.add(source.add_tone(tone[CONF_FREQUENCY], tone[CONF_AMPLITUDE], tone.get(CONF_CHANNEL, -1)))
+        if CONF_CHIRP in synthetic:
+            chirp = synthetic[CONF_CHIRP]
+            cg.add(source.set_chirp(chirp[CONF_START_FREQUENCY], chirp[CONF_END_FREQUENCY],
+                                    chirp[CONF_DURATION].total_milliseconds, chirp[CONF_AMPLITUDE]))
+        cg.add(source.set_white_noise(synthetic[CONF_WHITE_NOISE]))
+        cg.add(source.set_pink_noise(synthetic[CONF_PINK_NOISE]))
+        cg.add(var.set_audio_source(source))
+
+    # Tables constexpr en flash et tampons statiques, rien à construire dans setup() ;
+    # en multicanal les canaux partagent un plan et sont transformés par paires
+    fft_size = config[CONF_FFT_SIZE]
+    if (config[CONF_STATIC_TABLES] and config[CONF_PRECISION] == "float" and config[CONF_CHANNELS] == 1
+            and fft_size in STATIC_FFT_SIZES and not skips_fft(config) and CONF_ZOOM not in config
+            and CONF_RESOLUTIONS not in config):
+        static_fft = f"{config[CONF_ID]}_static_fft"
+        cg.add_global(cg.RawStatement(f"static esphome::realtime_fft::StaticFFT<{fft_size}> {static_fft};"))
+        cg.add(var.set_static_fft(cg.RawExpression(f"&{static_fft}")))
+
+    # Réduction du spectre en bandes, une table de poids creuse calculée une fois
+    if CONF_BANDS in config:
+        bands = config[CONF_BANDS]
+        cg.add(var.set_band_layout(bands[CONF_SCALE], bands[CONF_COUNT],
+                                   bands[CONF_MIN_FREQUENCY], bands[CONF_MAX_FREQUENCY]))
+        for conf in bands[CONF_SENSORS]:
+            sens = await sensor.new_sensor(conf)
+            cg.add(var.add_band_sensor(conf[CONF_BAND], sens))
+
+    # Filtres de Goertzel échantillon par échantillon, ou lecture des raies de la FFT
+    if CONF_SPARSE in config:
+        sparse = config[CONF_SPARSE]
+        cg.add(var.set_sparse_engine(sparse[CONF_ENGINE]))
+        cg.add(var.set_sliding_damping(sparse[CONF_DAMPING]))
+        for target in sparse[CONF_TARGETS]:
+            sens = await sensor.new_sensor(target[CONF_SENSOR]) if CONF_SENSOR in target else cg.nullptr
+            cg.add(var.add_target(target[CONF_FREQUENCY], sens))
+
+    # Chaque trame est calculée, seules les valeurs agrégées sont publiées
+    if CONF_PUBLISH in config:
+        publish = config[CONF_PUBLISH]
+        interval = publish[CONF_INTERVAL].total_milliseconds if CONF_INTERVAL in publish else 0
+        cg.add(var.set_publish_window(publish[CONF_MODE], publish.get(CONF_FRAMES, 0), interval))
+        cg.add(var.set_publish_delta(publish[CONF_DELTA]))
+
+    # Le drapeau de compilation retire complètement la mesure des étapes
+    if not config[CONF_INSTRUMENTATION]:
+        cg.add_define("REALTIME_FFT_NO_INSTRUMENTATION")
+    if CONF_DIAGNOSTICS in config:
+        diagnostics = config[CONF_DIAGNOSTICS]
+        cg.add(var.set_stats_interval(diagnostics[CONF_UPDATE_INTERVAL].total_milliseconds))
+        for key, setter in (
+            (CONF_CPU_LOAD, var.set_cpu_load_sensor),
+            (CONF_FFT_TIME, var.set_fft_time_sensor),
+            (CONF_FRAME_TIME, var.set_frame_time_sensor),
+            (CONF_OVERRUNS, var.set_overruns_sensor),
+            (CONF_DROPPED_FRAMES, var.set_dropped_frames_sensor),
+            (CONF_SKIPPED_FRAMES, var.set_skipped_frames_sensor),
+        ):
+            if key in diagnostics:
+                sens = await sensor.new_sensor(diagnostics[key])
+                cg.add(setter(sens))
 
 print(">>> Enregistrement du sensor realtime_fft terminé !")
 
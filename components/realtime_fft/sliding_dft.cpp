@@ -0,0 +1,95 @@
+#include "sliding_dft.h"
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace realtime_fft {
+
+template<typename T> static constexpr float full_scale() { return 1.0f; }
+template<> constexpr float full_scale<int16_t>() { return 1.0f / 32768.0f; }
+template<> constexpr float full_scale<int32_t>() { return 1.0f / 2147483648.0f; }
+
+SlidingDFT::SlidingDFT(int sample_rate, size_t window_size, const std::vector<float> &frequencies, float damping) {
+  if (sample_rate <= 0 || window_size < 2 || frequencies.empty() || !(damping > 0.0f && damping < 1.0f))
+    return;
+  this->window_size_ = window_size;
+  this->count_ = frequencies.size();
+
+  const size_t resonators = 3 * frequencies.size();
+  this->pole_re_.resize(resonators);
+  this->pole_im_.resize(resonators);
+  this->in_re_.resize(resonators);
+  this->in_im_.resize(resonators);
+  this->out_re_.resize(resonators);
+  this->out_im_.resize(resonators);
+  // Computed in double so that the pole's float rounding stays far below 1 - r
+  const double n = static_cast<double>(window_size);
+  const double r = damping;
+  const double r_n = std::pow(r, n);
+  const double spacing = 2.0 * M_PI / (n - 1.0);
+  for (size_t i = 0; i < resonators; i++) {
+    const double w = 2.0 * M_PI * frequencies[i / 3] / sample_rate + (static_cast<double>(i % 3) - 1.0) * spacing;
+    this->pole_re_[i] = static_cast<float>(r * std::cos(w));
+    this->pole_im_[i] = static_cast<float>(r * std::sin(w));
+    this->in_re_[i] = static_cast<float>(std::cos(w * (n - 1.0)));
+    this->in_im_[i] = static_cast<float>(-std::sin(w * (n - 1.0)));
+    this->out_re_[i] = static_cast<float>(r_n * std::cos(w));
+    this->out_im_[i] = static_cast<float>(r_n * std::sin(w));
+  }
+  this->history_.resize(window_size);
+  this->reset();
+}
+
+void SlidingDFT::reset() {
+  this->state_re_.assign(this->pole_re_.size(), 0.0f);
+  this->state_im_.assign(this->pole_re_.size(), 0.0f);
+  std::fill(this->history_.begin(), this->history_.end(), 0.0f);
+  this->position_ = 0;
+}
+
+void SlidingDFT::step_(float sample) {
+  const float leaving = this->history_[this->position_];
+  this->history_[this->position_] = sample;
+  if (++this->position_ == this->window_size_)
+    this->position_ = 0;
+
+  float *sr = this->state_re_.data(), *si = this->state_im_.data();
+  const float *pr = this->pole_re_.data(), *pi = this->pole_im_.data();
+  const float *ir = this->in_re_.data(), *ii = this->in_im_.data();
+  const float *orr = this->out_re_.data(), *oi = this->out_im_.data();
+  for (size_t i = 0; i < this->pole_re_.size(); i++) {
+    const float re = sr[i] * pr[i] - si[i] * pi[i] + sample * ir[i] - leaving * orr[i];
+    si[i] = sr[i] * pi[i] + si[i] * pr[i] + sample * ii[i] - leaving * oi[i];
+    sr[i] = re;
+  }
+}
+
+// Hann window as a three-tap kernel on the spectrum: 0.5 X(w) - 0.25 (X(w - d) + X(w + d))
+float SlidingDFT::power_(size_t i) const {
+  const float *sr = this->state_re_.data() + 3 * i, *si = this->state_im_.data() + 3 * i;
+  const float re = 0.5f * sr[1] - 0.25f * (sr[0] + sr[2]);
+  const float im = 0.5f * si[1] - 0.25f * (si[0] + si[2]);
+  return re * re + im * im;
+}
+
+float SlidingDFT::magnitude(size_t i) const { return i < this->count_ ? std::sqrt(this->power_(i)) : 0.0f; }
+
+template<typename T> void SlidingDFT::push(const T *samples, size_t count, size_t stride, float *peaks) {
+  if (peaks == nullptr) {
+    for (size_t i = 0; i < count; i += stride)
+      this->step_(samples[i] * full_scale<T>());
+    return;
+  }
+  for (size_t i = 0; i < count; i += stride) {
+    this->step_(samples[i] * full_scale<T>());
+    for (size_t f = 0; f < this->count_; f++)
+      peaks[f] = std::max(peaks[f], this->power_(f));
+  }
+}
+
+template void SlidingDFT::push<float>(const float *, size_t, size_t, float *);
+template void SlidingDFT::push<int16_t>(const int16_t *, size_t, size_t, float *);
+template void SlidingDFT::push<int32_t>(const int32_t *, size_t, size_t, float *);
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Sliding DFT at a handful of frequencies, updated on every sample.
+//
+// A block FFT only reports a change once a whole frame has gone by; here each
+// frequency keeps the DFT of the last window_size samples and updates it in
+// O(1) per sample as one sample enters and the oldest leaves:
+//
+//   S(n) = r e^(iw) S(n-1) + e^(-iw(N-1)) x(n) - r^N e^(iw) x(n-N)
+//
+// A plain sliding DFT (r = 1) sits on the unit circle, so float rounding in
+// the pole makes it drift or grow without bound. The damping r < 1 moves the
+// pole inside and makes old errors decay; it also tapers the window slightly
+// (the oldest sample weighs r^(N-1)). Frequencies need not be on a bin.
+//
+// The Hann window is applied in the frequency domain from two extra
+// resonators at w +- 2 pi / (N - 1), so powers match FFTPlan's windowed
+// real transform and the Goertzel bank, up to the damping taper.
+class SlidingDFT {
+ public:
+  SlidingDFT(int sample_rate, size_t window_size, const std::vector<float> &frequencies, float damping = 0.99999f);
+
+  bool is_valid() const { return this->window_size_ != 0; }
+  size_t size() const { return this->count_; }
+  size_t window_size() const { return this->window_size_; }
+
+  // Feeds count samples, taking every stride-th one (channel 0 of interleaved
+  // input). Integer samples are scaled so that full scale is 1.0. When peaks
+  // is given, peaks[i] is raised to the largest power of frequency i seen
+  // after any of these samples.
+  template<typename T> void push(const T *samples, size_t count, size_t stride, float *peaks = nullptr);
+
+  // Windowed power at frequency i after the last sample
+  float power(size_t i) const { return i < this->count_ ? this->power_(i) : 0.0f; }
+  // Windowed magnitude at frequency i after the last sample
+  float magnitude(size_t i) const;
+
+  // Clears the history, as if window_size zeros had been pushed
+  void reset();
+
+ protected:
+  void step_(float sample);
+  float power_(size_t i) const;
+
+  size_t window_size_{0};
+  size_t count_{0};
+  // Three resonators per frequency (w - d, w, w + d), as split arrays:
+  // pole r e^(iw), input gain e^(-iw(N-1)), output gain r^N e^(iw), state
+  std::vector<float> pole_re_, pole_im_;
+  std::vector<float> in_re_, in_im_;
+  std::vector<float> out_re_, out_im_;
+  std::vector<float> state_re_, state_im_;
+  // The last window_size samples
+  std::vector<float> history_;
+  size_t position_{0};
+};
+
+extern template void SlidingDFT::push<float>(const float *, size_t, size_t, float *);
+extern template void SlidingDFT::push<int16_t>(const int16_t *, size_t, size_t, float *);
+extern template void SlidingDFT::push<int32_t>(const int32_t *, size_t, size_t, float *);
+
+}  // namespace realtime_fft
+}  // namespace esphome
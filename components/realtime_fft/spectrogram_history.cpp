@@ -0,0 +1,140 @@
+#include "spectrogram_history.h"
+#include <algorithm>
+
+namespace esphome {
+namespace realtime_fft {
+
+static size_t row_bytes(size_t bins, HistoryDepth depth) { return depth == HISTORY_4BIT ? (bins + 1) / 2 : bins; }
+
+static uint8_t max_code(HistoryDepth depth) { return depth == HISTORY_4BIT ? 15 : 255; }
+
+size_t HistorySlice::slot_(size_t frame) const {
+  const size_t slot = this->first_ + frame;
+  return slot >= this->history_->capacity_ ? slot - this->history_->capacity_ : slot;
+}
+
+uint32_t HistorySlice::timestamp(size_t frame) const { return this->history_->timestamps_[this->slot_(frame)]; }
+
+float HistorySlice::at(size_t frame, size_t bin) const {
+  return this->history_->level_(this->slot_(frame), this->bin_begin_ + bin);
+}
+
+void HistorySlice::decode(size_t frame, float *out) const {
+  const size_t slot = this->slot_(frame);
+  for (size_t k = this->bin_begin_; k < this->bin_end_; k++)
+    *out++ = this->history_->level_(slot, k);
+}
+
+SpectrogramHistory::SpectrogramHistory(size_t bins, size_t capacity, HistoryDepth depth, float floor_db,
+                                       float range_db, uint8_t *storage)
+    : depth_(depth), floor_db_(floor_db), range_db_(range_db) {
+  if (bins == 0 || capacity == 0 || !(range_db > 0.0f))
+    return;
+  this->bins_ = bins;
+  this->capacity_ = capacity;
+  this->row_bytes_ = row_bytes(bins, depth);
+  if (storage == nullptr) {
+    this->owned_.resize(storage_size(bins, capacity, depth));
+    storage = this->owned_.data();
+  }
+  // Timestamps and scales first, so they stay 4-byte aligned
+  this->timestamps_ = reinterpret_cast<uint32_t *>(storage);
+  storage += capacity * sizeof(uint32_t);
+  if (depth == HISTORY_4BIT) {
+    this->scales_ = reinterpret_cast<FrameScale *>(storage);
+    storage += capacity * sizeof(FrameScale);
+  }
+  this->codes_ = storage;
+}
+
+size_t SpectrogramHistory::storage_size(size_t bins, size_t capacity, HistoryDepth depth) {
+  const size_t header = sizeof(uint32_t) + (depth == HISTORY_4BIT ? sizeof(FrameScale) : 0);
+  return capacity * (header + row_bytes(bins, depth));
+}
+
+void SpectrogramHistory::append(const float *spectrum, const SpectrumFormat &format, uint32_t timestamp) {
+  if (!this->is_valid())
+    return;
+  const size_t slot = this->head_;
+  this->timestamps_[slot] = timestamp;
+  format.with_db_reader([this, spectrum, slot](auto to_db) { this->quantise_(spectrum, to_db, slot); });
+  this->head_ = slot + 1 == this->capacity_ ? 0 : slot + 1;
+  if (this->count_ < this->capacity_)
+    this->count_++;
+}
+
+template<typename ToDb> void SpectrogramHistory::quantise_(const float *spectrum, ToDb to_db, size_t slot) {
+  float bottom = this->floor_db_;
+  float step = this->range_db_ / 255.0f;
+  if (this->depth_ == HISTORY_4BIT) {
+    // The loudest bin sets the frame's scale; bins order the same in any format
+    const float top = to_db(*std::max_element(spectrum, spectrum + this->bins_));
+    bottom = std::max(this->floor_db_, top - this->range_db_);
+    step = std::max(top - bottom, 0.0f) / 15.0f;
+    this->scales_[slot] = FrameScale{bottom, step};
+  }
+  const float scale = step > 0.0f ? 1.0f / step : 0.0f;
+  const float top_code = max_code(this->depth_);
+  auto code = [to_db, bottom, scale, top_code](float value) {
+    const float c = (to_db(value) - bottom) * scale + 0.5f;
+    return static_cast<uint8_t>(std::min(std::max(c, 0.0f), top_code));
+  };
+
+  uint8_t *row = this->codes_ + slot * this->row_bytes_;
+  if (this->depth_ == HISTORY_8BIT) {
+    for (size_t k = 0; k < this->bins_; k++)
+      row[k] = code(spectrum[k]);
+    return;
+  }
+  // Even bins in the low nibble
+  size_t k = 0;
+  for (; k + 1 < this->bins_; k += 2)
+    row[k / 2] = code(spectrum[k]) | (code(spectrum[k + 1]) << 4);
+  if (k < this->bins_)
+    row[k / 2] = code(spectrum[k]);
+}
+
+float SpectrogramHistory::level_(size_t slot, size_t bin) const {
+  const uint8_t *row = this->codes_ + slot * this->row_bytes_;
+  if (this->depth_ == HISTORY_8BIT)
+    return this->floor_db_ + row[bin] * (this->range_db_ / 255.0f);
+  const uint8_t code = (row[bin / 2] >> (4 * (bin & 1))) & 0x0F;
+  return this->scales_[slot].bottom + code * this->scales_[slot].step;
+}
+
+HistorySlice SpectrogramHistory::make_slice_(size_t first, size_t frames, size_t bin_begin, size_t bin_end) const {
+  HistorySlice slice;
+  slice.history_ = this;
+  slice.first_ = frames > 0 ? this->slot_(first) : 0;
+  slice.frames_ = frames;
+  slice.bin_end_ = std::min(bin_end, this->bins_);
+  slice.bin_begin_ = std::min(bin_begin, slice.bin_end_);
+  return slice;
+}
+
+HistorySlice SpectrogramHistory::slice(uint32_t from, uint32_t to, size_t bin_begin, size_t bin_end) const {
+  // First frame at or after t (after t when not inclusive), comparing modulo 2^32
+  auto lower_bound = [this](uint32_t t, bool inclusive) {
+    size_t low = 0, high = this->count_;
+    while (low < high) {
+      const size_t mid = (low + high) / 2;
+      const int32_t diff = static_cast<int32_t>(this->timestamps_[this->slot_(mid)] - t);
+      if (diff < 0 || (!inclusive && diff == 0))
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    return low;
+  };
+  const size_t first = lower_bound(from, true);
+  const size_t end = lower_bound(to, false);
+  return this->make_slice_(first, end > first ? end - first : 0, bin_begin, bin_end);
+}
+
+HistorySlice SpectrogramHistory::latest(size_t frames, size_t bin_begin, size_t bin_end) const {
+  frames = std::min(frames, this->count_);
+  return this->make_slice_(this->count_ - frames, frames, bin_begin, bin_end);
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
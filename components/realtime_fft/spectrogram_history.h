@@ -0,0 +1,132 @@
+#pragma once
+
+#include "spectrum_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Bits per stored bin
+enum HistoryDepth : uint8_t {
+  // Fixed dB scale from floor_db to floor_db + range_db, 0.47 dB per step over 120 dB
+  HISTORY_8BIT = 0,
+  // 16 steps spanning range_db below each frame's loudest bin, scale kept per frame
+  HISTORY_4BIT,
+};
+
+class SpectrogramHistory;
+
+// Read-only window onto a range of stored frames and bins. It points into the
+// history itself, so nothing is copied; bins are decoded to dB on access, and
+// the window stays valid only until the next append() overwrites its frames.
+class HistorySlice {
+ public:
+  HistorySlice() = default;
+
+  bool empty() const { return this->frames_ == 0 || this->bin_end_ <= this->bin_begin_; }
+  // Frames, oldest first, and bins of each frame
+  size_t frames() const { return this->frames_; }
+  size_t bins() const { return this->bin_end_ - this->bin_begin_; }
+  size_t bin_begin() const { return this->bin_begin_; }
+
+  uint32_t timestamp(size_t frame) const;
+  // Level of bin (counted from bin_begin()) in frame, in dB
+  float at(size_t frame, size_t bin) const;
+  // Decodes one frame's bins into out, bins() floats
+  void decode(size_t frame, float *out) const;
+
+ protected:
+  friend class SpectrogramHistory;
+
+  // Slot of the slice's frame-th frame
+  size_t slot_(size_t frame) const;
+
+  const SpectrogramHistory *history_{nullptr};
+  // Slot of the first frame, so appends that leave the frames in place leave
+  // the slice unchanged too
+  size_t first_{0};
+  size_t frames_{0};
+  size_t bin_begin_{0};
+  size_t bin_end_{0};
+};
+
+// Circular store of the last capacity() spectra, quantised to 8 or 4 bits of dB.
+//
+// A float frame of n bins costs 4n bytes; here it is n or n/2 bytes plus a
+// timestamp (and, at 4 bits, a per-frame scale), so minutes of spectrogram
+// fit where a few float frames did. Appending writes one row in place and
+// moves the head, O(1) with no allocation; queries return HistorySlice views
+// by time and bin range without copying. Levels are 20 log10(|X| / reference)
+// with the reference of the format the spectra come in, whatever their scale.
+//
+// Timestamps are any increasing 32-bit clock (millis(), a frame counter) and
+// are compared modulo 2^32, so the clock may wrap. Not thread-safe: append
+// and query from the same task.
+class SpectrogramHistory {
+ public:
+  // storage, if given, holds storage_size() bytes and must outlive the history;
+  // otherwise the history allocates its own.
+  // The default scale covers -40 to 80 dB, which fits unnormalised FFT bins
+  // (a full-scale tone reaches about 20 log10(N / 4) dB) with reference 1.
+  SpectrogramHistory(size_t bins, size_t capacity, HistoryDepth depth, float floor_db = -40.0f,
+                     float range_db = 120.0f, uint8_t *storage = nullptr);
+
+  static size_t storage_size(size_t bins, size_t capacity, HistoryDepth depth);
+
+  bool is_valid() const { return this->capacity_ != 0; }
+  size_t bins() const { return this->bins_; }
+  size_t capacity() const { return this->capacity_; }
+  // Frames stored so far, up to capacity()
+  size_t size() const { return this->count_; }
+  HistoryDepth depth() const { return this->depth_; }
+
+  // Quantises bins() values of spectrum, given in format, and stores them as
+  // the newest frame, dropping the oldest once full.
+  void append(const float *spectrum, const SpectrumFormat &format, uint32_t timestamp);
+  void clear() { this->count_ = 0; }
+
+  // Frames with from <= timestamp <= to and bins [bin_begin, bin_end), the
+  // latter clamped to bins(). Found by binary search over the timestamps.
+  HistorySlice slice(uint32_t from, uint32_t to, size_t bin_begin = 0, size_t bin_end = SIZE_MAX) const;
+  // The newest frames, all bins or a bin range
+  HistorySlice latest(size_t frames, size_t bin_begin = 0, size_t bin_end = SIZE_MAX) const;
+
+ protected:
+  friend class HistorySlice;
+
+  // 4-bit frames: level = bottom + code * step
+  struct FrameScale {
+    float bottom;
+    float step;
+  };
+
+  // Slot of the frame at age order index i, 0 = oldest
+  size_t slot_(size_t index) const {
+    const size_t slot = this->head_ + this->capacity_ - this->count_ + index;
+    return slot >= this->capacity_ ? slot - this->capacity_ : slot;
+  }
+  HistorySlice make_slice_(size_t first, size_t frames, size_t bin_begin, size_t bin_end) const;
+  template<typename ToDb> void quantise_(const float *spectrum, ToDb to_db, size_t slot);
+  float level_(size_t slot, size_t bin) const;
+
+  size_t bins_{0};
+  size_t capacity_{0};
+  HistoryDepth depth_;
+  float floor_db_;
+  float range_db_;
+  // Bytes per stored row
+  size_t row_bytes_{0};
+  // Slot the next frame goes to, and frames held
+  size_t head_{0};
+  size_t count_{0};
+
+  std::vector<uint8_t> owned_;
+  uint32_t *timestamps_{nullptr};
+  FrameScale *scales_{nullptr};
+  uint8_t *codes_{nullptr};
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace esphome {
+namespace realtime_fft {
+
+// What a spectrum bin holds
+enum SpectrumScale : uint8_t {
+  // |X|
+  SPECTRUM_MAGNITUDE = 0,
+  // |X|^2, no square root at all
+  SPECTRUM_POWER,
+  // 10 log10(|X|^2 / reference^2), clamped below at the floor
+  SPECTRUM_DB,
+};
+
+// log2(x) for x > 0 from the float's exponent field plus a cubic on the
+// mantissa (exact at powers of two, error below 9e-4, i.e. 0.003 dB). It is
+// branch-free, so loops over it vectorise; 0 comes out near -127, which any
+// sensible dB floor clamps.
+inline float fast_log2(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  const float exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+  bits = (bits & 0x007FFFFF) | 0x3F800000;
+  float t;
+  std::memcpy(&t, &bits, sizeof(t));
+  t -= 1.0f;
+  return exponent + t * (1.4228193f + t * (-0.58197006f + t * 0.15915075f));
+}
+
+// How an engine turns |X|^2 into output bins, and back for consumers that
+// need a particular scale (band energies, peak interpolation).
+class SpectrumFormat {
+ public:
+  SpectrumFormat() = default;
+  // reference is the magnitude read as 0 dB; both only matter for SPECTRUM_DB
+  explicit SpectrumFormat(SpectrumScale scale, float reference = 1.0f, float floor_db = -120.0f)
+      : scale_(scale), reference_(reference), floor_db_(floor_db) {
+    this->db_offset_ = 20.0f * std::log10(reference);
+  }
+
+  SpectrumScale scale() const { return this->scale_; }
+  float reference() const { return this->reference_; }
+  float floor_db() const { return this->floor_db_; }
+
+  // Calls body(convert), where convert maps |X|^2 to an output bin and is
+  // specialised for the scale, so the switch runs once per frame and the
+  // per-bin loop inside body inlines a single conversion.
+  template<typename Body> void with_converter(Body &&body) const {
+    switch (this->scale_) {
+      case SPECTRUM_POWER:
+        body([](float power) { return power; });
+        break;
+      case SPECTRUM_DB: {
+        const float offset = this->db_offset_, floor_db = this->floor_db_;
+        body([offset, floor_db](float power) { return std::max(DB_PER_OCTAVE * fast_log2(power) - offset, floor_db); });
+        break;
+      }
+      default:
+        body([](float power) { return std::sqrt(power); });
+        break;
+    }
+  }
+
+  // Calls body(to_db), where to_db maps one bin of this format to
+  // 20 log10(|X| / reference) with fast_log2; silent bins come out far below
+  // any useful floor rather than at -inf.
+  template<typename Body> void with_db_reader(Body &&body) const {
+    const float offset = this->db_offset_;
+    switch (this->scale_) {
+      case SPECTRUM_POWER:
+        body([offset](float power) { return DB_PER_OCTAVE * fast_log2(power) - offset; });
+        break;
+      case SPECTRUM_DB:
+        body([](float db) { return db; });
+        break;
+      default:
+        body([offset](float magnitude) { return 2.0f * DB_PER_OCTAVE * fast_log2(magnitude) - offset; });
+        break;
+    }
+  }
+
+  // out[k] = converted |real[k] + i imag[k]|^2 for k < count; out may alias
+  // real or imag.
+  void from_complex(const float *real, const float *imag, float *out, size_t count) const {
+    this->with_converter([real, imag, out, count](auto convert) {
+      for (size_t k = 0; k < count; k++)
+        out[k] = convert(real[k] * real[k] + imag[k] * imag[k]);
+    });
+  }
+  // Converts count |X|^2 values in place
+  void from_power(float *values, size_t count) const {
+    this->with_converter([values, count](auto convert) {
+      for (size_t k = 0; k < count; k++)
+        values[k] = convert(values[k]);
+    });
+  }
+
+  // One bin back to |X|^2 or |X|
+  float to_power(float value) const {
+    switch (this->scale_) {
+      case SPECTRUM_POWER:
+        return value;
+      case SPECTRUM_DB:
+        return std::pow(10.0f, 0.1f * (value + this->db_offset_));
+      default:
+        return value * value;
+    }
+  }
+  float to_magnitude(float value) const {
+    switch (this->scale_) {
+      case SPECTRUM_POWER:
+        return std::sqrt(value);
+      case SPECTRUM_DB:
+        return std::pow(10.0f, 0.05f * (value + this->db_offset_));
+      default:
+        return value;
+    }
+  }
+  // ln |X|, finite even for silent bins; what peak interpolation works on
+  float to_log_magnitude(float value) const {
+    switch (this->scale_) {
+      case SPECTRUM_POWER:
+        return 0.5f * std::log(std::max(value, 1e-37f));
+      case SPECTRUM_DB:
+        return (value + this->db_offset_) * (LN_10 / 20.0f);
+      default:
+        return std::log(std::max(value, 1e-30f));
+    }
+  }
+
+ protected:
+  // 10 log10(2)
+  static constexpr float DB_PER_OCTAVE = 3.01029996f;
+  static constexpr float LN_10 = 2.30258509f;
+
+  SpectrumScale scale_{SPECTRUM_MAGNITUDE};
+  float reference_{1.0f};
+  float floor_db_{-120.0f};
+  // 20 log10(reference)
+  float db_offset_{0.0f};
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
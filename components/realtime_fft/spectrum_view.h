@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Read-only, non-owning view of a block of spectrum values.
+//
+// Points straight into the analyser's own buffer, so it is only valid until
+// the next frame is processed.
+class SpectrumView {
+ public:
+  SpectrumView() = default;
+  SpectrumView(const float *data, size_t size) : data_(data), size_(size) {}
+
+  const float *data() const { return this->data_; }
+  size_t size() const { return this->size_; }
+  bool empty() const { return this->size_ == 0; }
+
+  const float *begin() const { return this->data_; }
+  const float *end() const { return this->data_ + this->size_; }
+  float operator[](size_t i) const { return this->data_[i]; }
+
+ protected:
+  const float *data_{nullptr};
+  size_t size_{0};
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Lock-free single-producer/single-consumer ring buffer.
+//
+// One task may push while another pops, without locks or blocking. Reads and
+// writes are all-or-nothing so whole samples or chunks never get split, and the
+// capacity is rounded up to a power of two so indices wrap with a mask.
+template<typename T> class SpscRingBuffer {
+ public:
+  // storage, if given, holds storage_size(capacity) elements and must outlive
+  // the buffer; otherwise the buffer allocates its own.
+  explicit SpscRingBuffer(size_t capacity, T *storage = nullptr) {
+    const size_t size = storage_size(capacity);
+    if (storage == nullptr) {
+      this->owned_.resize(size);
+      storage = this->owned_.data();
+    }
+    this->buffer_ = storage;
+    this->mask_ = size - 1;
+  }
+
+  static size_t storage_size(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity)
+      size *= 2;
+    return size;
+  }
+
+  size_t capacity() const { return this->mask_ + 1; }
+  // Elements ready for the consumer
+  size_t available() const {
+    return this->head_.load(std::memory_order_acquire) - this->tail_.load(std::memory_order_acquire);
+  }
+
+  // Producer side: copies all count elements, or nothing if they don't fit.
+  bool push(const T *data, size_t count) {
+    const size_t head = this->head_.load(std::memory_order_relaxed);
+    const size_t tail = this->tail_.load(std::memory_order_acquire);
+    if (this->capacity() - (head - tail) < count)
+      return false;
+    const size_t start = head & this->mask_;
+    const size_t first = std::min(count, this->capacity() - start);
+    std::memcpy(this->buffer_ + start, data, first * sizeof(T));
+    std::memcpy(this->buffer_, data + first, (count - first) * sizeof(T));
+    this->head_.store(head + count, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side: copies out exactly count elements, or nothing if fewer are buffered.
+  bool pop(T *data, size_t count) {
+    const size_t tail = this->tail_.load(std::memory_order_relaxed);
+    const size_t head = this->head_.load(std::memory_order_acquire);
+    if (head - tail < count)
+      return false;
+    const size_t start = tail & this->mask_;
+    const size_t first = std::min(count, this->capacity() - start);
+    std::memcpy(data, this->buffer_ + start, first * sizeof(T));
+    std::memcpy(data + first, this->buffer_, (count - first) * sizeof(T));
+    this->tail_.store(tail + count, std::memory_order_release);
+    return true;
+  }
+
+ protected:
+  std::vector<T> owned_;
+  T *buffer_;
+  size_t mask_{0};
+  // Monotonic counters; head is only written by the producer, tail by the consumer
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,324 @@
+#pragma once
+
+#include "fft_kernels.h"
+#include "spectrum_format.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace esphome {
+namespace realtime_fft {
+
+namespace static_fft_detail {
+
+constexpr double PI = 3.14159265358979323846;
+
+// std::sin/std::cos are not constexpr in C++17, so the tables use a Taylor
+// series after reducing the argument to [-pi/2, pi/2].
+constexpr double sin(double x) {
+  while (x > PI)
+    x -= 2 * PI;
+  while (x < -PI)
+    x += 2 * PI;
+  if (x > PI / 2)
+    x = PI - x;
+  if (x < -PI / 2)
+    x = -PI - x;
+  double term = x, sum = x;
+  for (int k = 1; k < 14; k++) {
+    term *= -x * x / ((2 * k) * (2 * k + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double cos(double x) { return sin(x + PI / 2); }
+
+constexpr size_t log2(size_t n) {
+  size_t bits = 0;
+  while ((size_t(1) << bits) < n)
+    bits++;
+  return bits;
+}
+
+constexpr size_t reverse_bits(size_t i, size_t bits) {
+  size_t rev = 0;
+  for (size_t b = 0; b < bits; b++)
+    rev |= ((i >> b) & 1) << (bits - 1 - b);
+  return rev;
+}
+
+constexpr size_t count_swaps(size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (i < reverse_bits(i, log2(n)))
+      count++;
+  }
+  return count;
+}
+
+}  // namespace static_fft_detail
+
+// Lets the component hold any StaticFFT<N, T> behind one pointer.
+class StaticFFTBase {
+ public:
+  virtual ~StaticFFTBase() = default;
+  virtual size_t size() const = 0;
+  // Windows and transforms one frame of size() samples into size()/2 bins in
+  // the given format, computed in the final pass.
+  virtual void spectrum(const float *frame, float *out, const SpectrumFormat &format) = 0;
+  // Same, as magnitudes.
+  void magnitudes(const float *frame, float *out) { this->spectrum(frame, out, SpectrumFormat()); }
+};
+
+// Real-input FFT specialised for one size at compile time.
+//
+// Same algorithm and table layout as FFTPlan::forward_real, but the twiddle,
+// window and bit-reversal tables are constexpr (so they land in rodata/flash
+// and nothing is built in setup()), the work buffers are members rather than
+// heap allocations, and the pass sequence is fixed at compile time: the
+// twiddle-free first pass is written out, and every stage whose butterflies
+// span at most UNROLLED_SPAN points is fully unrolled with its twiddles as
+// constants. On hosts the float passes still go to the vector kernels.
+// sensor.py picks this path when the YAML fft_size has an instantiation.
+template<size_t N, typename T = float> class StaticFFT : public StaticFFTBase {
+  static_assert(N >= 8 && N <= 4096 && (N & (N - 1)) == 0, "N must be a power of two between 8 and 4096");
+  static_assert(std::is_floating_point<T>::value, "StaticFFT works on floating-point samples");
+
+ public:
+  static constexpr size_t HALF = N / 2;
+  // Largest 4h of the fully unrolled radix-4 stages, which covers every stage
+  // of N <= 128 and the short early ones of larger sizes
+  static constexpr size_t UNROLLED_SPAN = 64;
+  static constexpr size_t SWAP_COUNT = static_fft_detail::count_swaps(HALF);
+
+  struct Tables {
+    // Per-stage twiddles, stage with half-length h at offset h - 1 (as in FFTPlan)
+    T twiddle_re[N - 1];
+    T twiddle_im[N - 1];
+    T window[N];
+    // (i, rev(i)) pairs of the N/2 bit reversal
+    uint16_t swaps[2 * SWAP_COUNT > 0 ? 2 * SWAP_COUNT : 1];
+  };
+
+  static constexpr Tables make_tables() {
+    Tables t{};
+    for (size_t h = 1; h < N; h *= 2) {
+      for (size_t j = 0; j < h; j++) {
+        double theta = -static_fft_detail::PI * j / h;
+        bool quarter = 2 * j == h;
+        t.twiddle_re[h - 1 + j] = quarter ? T(0) : static_cast<T>(static_fft_detail::cos(theta));
+        t.twiddle_im[h - 1 + j] = quarter ? T(-1) : static_cast<T>(static_fft_detail::sin(theta));
+      }
+    }
+    for (size_t i = 0; i < N; i++)
+      t.window[i] = static_cast<T>(0.5 * (1.0 - static_fft_detail::cos(2.0 * static_fft_detail::PI * i / (N - 1))));
+    size_t s = 0;
+    for (size_t i = 0; i < HALF; i++) {
+      size_t rev = static_fft_detail::reverse_bits(i, static_fft_detail::log2(HALF));
+      if (i < rev) {
+        t.swaps[s++] = static_cast<uint16_t>(i);
+        t.swaps[s++] = static_cast<uint16_t>(rev);
+      }
+    }
+    return t;
+  }
+
+  static constexpr Tables TABLES = make_tables();
+
+  size_t size() const override { return N; }
+
+  // Same contract as FFTPlan::forward_real with the window applied.
+  template<typename In> void forward_real(const In *in, T *real, T *imag) const {
+    this->forward_real(in, real, imag, [](size_t, T) {});
+  }
+
+  // Same, calling emit(k, |X[k]|^2) for every k < N/2 as the recombination
+  // produces the bin.
+  template<typename In, typename Emit> void forward_real(const In *in, T *real, T *imag, Emit emit) const {
+    for (size_t i = 0; i < HALF; i++) {
+      real[i] = in[2 * i] * TABLES.window[2 * i];
+      imag[i] = in[2 * i + 1] * TABLES.window[2 * i + 1];
+    }
+    for (size_t s = 0; s < 2 * SWAP_COUNT; s += 2) {
+      const size_t a = TABLES.swaps[s], b = TABLES.swaps[s + 1];
+      const T tr = real[a], ti = imag[a];
+      real[a] = real[b];
+      imag[a] = imag[b];
+      real[b] = tr;
+      imag[b] = ti;
+    }
+
+    // An odd number of radix-2 stages starts with one radix-2 pass
+    constexpr size_t FIRST = static_fft_detail::log2(HALF) & 1 ? 2 : 4;
+    if (FIRST == 2) {
+      for (size_t k = 0; k < HALF; k += 2) {
+        const T tr = real[k + 1], ti = imag[k + 1];
+        real[k + 1] = real[k] - tr;
+        imag[k + 1] = imag[k] - ti;
+        real[k] += tr;
+        imag[k] += ti;
+      }
+    } else {
+      // First radix-4 pass: twiddles are 1, 1 and -i, so no multiplies
+      for (size_t k = 0; k < HALF; k += 4) {
+        T *r = real + k, *q = imag + k;
+        const T a1r = r[0] + r[1], a1i = q[0] + q[1];
+        const T b1r = r[0] - r[1], b1i = q[0] - q[1];
+        const T c1r = r[2] + r[3], c1i = q[2] + q[3];
+        const T d1r = r[2] - r[3], d1i = q[2] - q[3];
+        r[0] = a1r + c1r;
+        q[0] = a1i + c1i;
+        r[2] = a1r - c1r;
+        q[2] = a1i - c1i;
+        r[1] = b1r + d1i;
+        q[1] = b1i - d1r;
+        r[3] = b1r - d1i;
+        q[3] = b1i + d1r;
+      }
+    }
+    if (!vector_passes_(real, imag, FIRST))
+      radix4_stages_<FIRST>(real, imag);
+
+    // Recombine the even/odd spectra, as in FFTPlan::forward_real
+    const T z0r = real[0], z0i = imag[0];
+    real[0] = z0r + z0i;
+    imag[0] = 0;
+    real[HALF] = z0r - z0i;
+    imag[HALF] = 0;
+    emit(size_t(0), real[0] * real[0]);
+    for (size_t k = 1; k <= HALF / 2; k++) {
+      const size_t j = HALF - k;
+      const T er = T(0.5) * (real[k] + real[j]);
+      const T ei = T(0.5) * (imag[k] - imag[j]);
+      const T orr = T(0.5) * (imag[k] + imag[j]);
+      const T oi = T(-0.5) * (real[k] - real[j]);
+      const T wr = TABLES.twiddle_re[HALF - 1 + k];
+      const T wi = TABLES.twiddle_im[HALF - 1 + k];
+      const T tr = wr * orr - wi * oi;
+      const T ti = wr * oi + wi * orr;
+      real[k] = er + tr;
+      imag[k] = ei + ti;
+      real[j] = er - tr;
+      imag[j] = ti - ei;
+      emit(k, real[k] * real[k] + imag[k] * imag[k]);
+      if (j != k)
+        emit(j, real[j] * real[j] + imag[j] * imag[j]);
+    }
+  }
+
+  void spectrum(const float *frame, float *out, const SpectrumFormat &format) override {
+    format.with_converter([this, frame, out](auto convert) {
+      this->forward_real(frame, this->real_, this->imag_,
+                         [out, convert](size_t k, T power) { out[k] = convert(static_cast<float>(power)); });
+    });
+  }
+
+ protected:
+#if defined(__SSE2__) || defined(__ARM_NEON)
+  // Hosts: the runtime-dispatched vector kernels beat the inlined scalar passes
+  static bool vector_passes_(T *real, T *imag, size_t h) {
+    if (!std::is_same<T, float>::value)
+      return false;
+    static const Radix4Kernel KERNEL = select_radix4_kernel();
+    for (; 4 * h <= HALF; h *= 4) {
+      KERNEL.pass(reinterpret_cast<float *>(real), reinterpret_cast<float *>(imag), HALF, h,
+                  reinterpret_cast<const float *>(TABLES.twiddle_re + h - 1),
+                  reinterpret_cast<const float *>(TABLES.twiddle_im + h - 1),
+                  reinterpret_cast<const float *>(TABLES.twiddle_re + 2 * h - 1),
+                  reinterpret_cast<const float *>(TABLES.twiddle_im + 2 * h - 1));
+    }
+    return true;
+  }
+#else
+  static bool vector_passes_(T *, T *, size_t) { return false; }
+#endif
+
+  // The radix-4 passes from half-length H on, one instantiation per stage
+  template<size_t H> static void radix4_stages_(T *real, T *imag) {
+    if constexpr (4 * H <= HALF) {
+      radix4_pass_<H>(real, imag);
+      radix4_stages_<4 * H>(real, imag);
+    }
+  }
+
+  template<size_t H> static void radix4_pass_(T *real, T *imag) {
+    if constexpr (4 * H <= UNROLLED_SPAN) {
+      // H is at most 16 here, and with j constant the twiddles fold into the code
+      for (size_t k = 0; k < HALF; k += 4 * H) {
+#pragma GCC unroll 16
+        for (size_t j = 0; j < H; j++)
+          butterfly_<H>(real + k, imag + k, j);
+      }
+    } else {
+      // Long stages gain nothing from unrolling but code size
+      radix4_pass(real, imag, H);
+    }
+  }
+
+  static void radix4_pass(T *real, T *imag, size_t h) {
+    const T *w1r = TABLES.twiddle_re + h - 1, *w1i = TABLES.twiddle_im + h - 1;
+    const T *w2r = TABLES.twiddle_re + 2 * h - 1, *w2i = TABLES.twiddle_im + 2 * h - 1;
+    for (size_t k = 0; k < HALF; k += 4 * h) {
+      T *ar = real + k, *br = ar + h, *cr = br + h, *dr = cr + h;
+      T *ai = imag + k, *bi = ai + h, *ci = bi + h, *di = ci + h;
+      for (size_t j = 0; j < h; j++) {
+        T tr = w1r[j] * br[j] - w1i[j] * bi[j];
+        T ti = w1r[j] * bi[j] + w1i[j] * br[j];
+        const T a1r = ar[j] + tr, a1i = ai[j] + ti;
+        const T b1r = ar[j] - tr, b1i = ai[j] - ti;
+        tr = w1r[j] * dr[j] - w1i[j] * di[j];
+        ti = w1r[j] * di[j] + w1i[j] * dr[j];
+        const T c1r = cr[j] + tr, c1i = ci[j] + ti;
+        const T d1r = cr[j] - tr, d1i = ci[j] - ti;
+        tr = w2r[j] * c1r - w2i[j] * c1i;
+        ti = w2r[j] * c1i + w2i[j] * c1r;
+        ar[j] = a1r + tr;
+        ai[j] = a1i + ti;
+        cr[j] = a1r - tr;
+        ci[j] = a1i - ti;
+        tr = w2r[j + h] * d1r - w2i[j + h] * d1i;
+        ti = w2r[j + h] * d1i + w2i[j + h] * d1r;
+        br[j] = b1r + tr;
+        bi[j] = b1i + ti;
+        dr[j] = b1r - tr;
+        di[j] = b1i - ti;
+      }
+    }
+  }
+
+  // Butterfly j of radix4_pass() for the block at (real, imag)
+  template<size_t H> static inline void butterfly_(T *real, T *imag, size_t j) {
+    const T *w1r = TABLES.twiddle_re + H - 1, *w1i = TABLES.twiddle_im + H - 1;
+    const T *w2r = TABLES.twiddle_re + 2 * H - 1, *w2i = TABLES.twiddle_im + 2 * H - 1;
+    T *ar = real, *br = ar + H, *cr = br + H, *dr = cr + H;
+    T *ai = imag, *bi = ai + H, *ci = bi + H, *di = ci + H;
+    T tr = w1r[j] * br[j] - w1i[j] * bi[j];
+    T ti = w1r[j] * bi[j] + w1i[j] * br[j];
+    const T a1r = ar[j] + tr, a1i = ai[j] + ti;
+    const T b1r = ar[j] - tr, b1i = ai[j] - ti;
+    tr = w1r[j] * dr[j] - w1i[j] * di[j];
+    ti = w1r[j] * di[j] + w1i[j] * dr[j];
+    const T c1r = cr[j] + tr, c1i = ci[j] + ti;
+    const T d1r = cr[j] - tr, d1i = ci[j] - ti;
+    tr = w2r[j] * c1r - w2i[j] * c1i;
+    ti = w2r[j] * c1i + w2i[j] * c1r;
+    ar[j] = a1r + tr;
+    ai[j] = a1i + ti;
+    cr[j] = a1r - tr;
+    ci[j] = a1i - ti;
+    tr = w2r[j + H] * d1r - w2i[j + H] * d1i;
+    ti = w2r[j + H] * d1i + w2i[j + H] * d1r;
+    br[j] = b1r + tr;
+    bi[j] = b1i + ti;
+    dr[j] = b1r - tr;
+    di[j] = b1i - ti;
+  }
+
+  T real_[HALF + 1];
+  T imag_[HALF + 1];
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,67 @@
+#include "stft_framer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace realtime_fft {
+
+template<typename T>
+StftFramer<T>::StftFramer(size_t frame_size, size_t hop_size, size_t channels, T *ring, T *frame) {
+  if (frame_size == 0 || hop_size == 0 || hop_size > frame_size || channels == 0)
+    return;
+  this->frame_size_ = frame_size;
+  this->hop_size_ = hop_size;
+  this->channels_ = channels;
+  const size_t samples = frame_size * channels;
+  this->owned_.resize((ring == nullptr ? samples : 0) + (frame == nullptr ? samples : 0));
+  this->ring_ = ring != nullptr ? ring : this->owned_.data();
+  this->frame_ = frame != nullptr ? frame : this->owned_.data() + (ring == nullptr ? samples : 0);
+  this->reset();
+}
+
+template<typename T> void StftFramer<T>::reset() {
+  std::fill_n(this->ring_, this->frame_size_ * this->channels_, T(0));
+  this->write_pos_ = 0;
+  this->until_next_ = this->frame_size_;
+}
+
+template<typename T> size_t StftFramer<T>::push(const T *samples, size_t count, const FrameCallback &callback) {
+  const size_t n = this->frame_size_;
+  const size_t channels = this->channels_;
+  size_t frames = 0;
+
+  // Positions and counts below are in sample frames
+  count /= channels;
+  while (count > 0) {
+    // Copy up to the next frame boundary or the end of the ring, whichever is first
+    size_t chunk = std::min(count, std::min(this->until_next_, n - this->write_pos_));
+    std::memcpy(this->ring_ + this->write_pos_ * channels, samples, chunk * channels * sizeof(T));
+    samples += chunk * channels;
+    count -= chunk;
+    this->write_pos_ = (this->write_pos_ + chunk) % n;
+    this->until_next_ -= chunk;
+
+    if (this->until_next_ == 0) {
+      // Oldest sample sits at the write position
+      size_t tail = n - this->write_pos_;
+      if (channels == 1) {
+        std::memcpy(this->frame_, this->ring_ + this->write_pos_, tail * sizeof(T));
+        std::memcpy(this->frame_ + tail, this->ring_, this->write_pos_ * sizeof(T));
+      } else {
+        deinterleave(this->ring_ + this->write_pos_ * channels, tail, channels, this->frame_, n);
+        deinterleave(this->ring_, this->write_pos_, channels, this->frame_ + tail, n);
+      }
+      callback(this->frame_);
+      this->until_next_ = this->hop_size_;
+      frames++;
+    }
+  }
+  return frames;
+}
+
+template class StftFramer<float>;
+template class StftFramer<int16_t>;
+template class StftFramer<int32_t>;
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Splits count interleaved multi-channel frames into planar blocks: channel c
+// lands at out + c * stride.
+template<typename T> void deinterleave(const T *in, size_t count, size_t channels, T *out, size_t stride) {
+  for (size_t c = 0; c < channels; c++) {
+    const T *src = in + c;
+    T *dst = out + c * stride;
+    for (size_t i = 0; i < count; i++)
+      dst[i] = src[i * channels];
+  }
+}
+
+// Turns a stream of arbitrarily sized sample chunks into overlapping frames.
+//
+// Samples go into a ring buffer of one frame; once the first full frame has
+// arrived, a linearized copy is handed to the callback every hop_size samples.
+// A hop of half or a quarter of the frame gives the usual 50%/75% STFT overlap.
+// T is the sample type: float, or int16_t/int32_t for the fixed-point engines.
+//
+// With several channels the input is interleaved as it comes off I2S and
+// frame_size/hop_size count sample frames (one sample per channel). The ring
+// keeps the interleaved layout and the copy handed to the callback is planar,
+// channel c at frame + c * frame_size, so de-interleaving costs no extra pass.
+//
+// The ring and the frame copy can be handed in (frame_size * channels samples
+// each, e.g. from a MemoryArena); the frame copy is rewritten whole before
+// every callback, so the callback may also use it as scratch.
+template<typename T> class StftFramer {
+ public:
+  using FrameCallback = std::function<void(T *frame)>;
+
+  StftFramer(size_t frame_size, size_t hop_size, size_t channels = 1, T *ring = nullptr, T *frame = nullptr);
+
+  bool is_valid() const { return this->frame_size_ != 0; }
+  size_t frame_size() const { return this->frame_size_; }
+  size_t hop_size() const { return this->hop_size_; }
+  size_t channels() const { return this->channels_; }
+
+  // Appends count samples (a multiple of channels()), invoking the callback once
+  // per completed frame. Returns the number of frames emitted.
+  size_t push(const T *samples, size_t count, const FrameCallback &callback);
+
+  // Drops buffered samples; the next frame needs a full frame of new input.
+  void reset();
+
+ protected:
+  size_t frame_size_{0};
+  size_t hop_size_{0};
+  size_t channels_{1};
+  std::vector<T> owned_;
+  T *ring_{nullptr};
+  T *frame_{nullptr};
+  size_t write_pos_{0};
+  size_t until_next_{0};
+};
+
+extern template class StftFramer<float>;
+extern template class StftFramer<int16_t>;
+extern template class StftFramer<int32_t>;
+
+}  // namespace realtime_fft
+}  // namespace esphome
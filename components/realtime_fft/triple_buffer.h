@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Lock-free triple buffer handing fixed-size snapshots from one producer to one consumer.
+//
+// The producer always has a private slot to fill and the consumer a private slot
+// to read; the third slot holds the newest finished snapshot. Publishing and
+// picking up a snapshot are single atomic exchanges, so the reader always sees a
+// complete frame and neither side ever waits for the other. Frames the reader
+// doesn't get to in time are simply replaced by newer ones.
+template<typename T> class TripleBuffer {
+ public:
+  // storage, if given, holds 3 * count elements and must outlive the buffer;
+  // otherwise the buffer allocates its own.
+  explicit TripleBuffer(size_t count, T *storage = nullptr) : count_(count) {
+    if (storage == nullptr) {
+      this->owned_.resize(3 * count);
+      storage = this->owned_.data();
+    }
+    this->data_ = storage;
+  }
+
+  size_t count() const { return this->count_; }
+
+  // Producer side: slot to fill, then publish() it.
+  T *write_buffer() { return this->data_ + this->write_ * this->count_; }
+  void publish() {
+    uint8_t prev = this->middle_.exchange(this->write_ | FRESH, std::memory_order_acq_rel);
+    this->write_ = prev & INDEX_MASK;
+  }
+
+  // Consumer side: adopts the newest snapshot if one was published since the
+  // last call. read_buffer() stays untouched until the next successful update().
+  bool update() {
+    if ((this->middle_.load(std::memory_order_acquire) & FRESH) == 0)
+      return false;
+    uint8_t prev = this->middle_.exchange(this->read_, std::memory_order_acq_rel);
+    this->read_ = prev & INDEX_MASK;
+    return true;
+  }
+  T *read_buffer() { return this->data_ + this->read_ * this->count_; }
+
+ protected:
+  static constexpr uint8_t INDEX_MASK = 0x03;
+  static constexpr uint8_t FRESH = 0x04;
+
+  std::vector<T> owned_;
+  T *data_;
+  size_t count_;
+  uint8_t write_{0};
+  uint8_t read_{1};
+  std::atomic<uint8_t> middle_{2};
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
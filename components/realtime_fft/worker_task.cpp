@@ -0,0 +1,63 @@
+#include "worker_task.h"
+#include <utility>
+
+#ifndef ESP_PLATFORM
+#include <chrono>
+#endif
+
+namespace esphome {
+namespace realtime_fft {
+
+bool WorkerTask::start(Body body, const char *name, int core, int priority, uint32_t stack_size) {
+  if (this->running_.load())
+    return false;
+  this->body_ = std::move(body);
+  this->running_.store(true);
+#ifdef ESP_PLATFORM
+  // Single-core chips (S2, C3) run everything on core 0
+  if (core >= portNUM_PROCESSORS)
+    core = tskNO_AFFINITY;
+  if (xTaskCreatePinnedToCore(task_main, name, stack_size, this, priority, &this->task_, core) != pdPASS) {
+    this->running_.store(false);
+    return false;
+  }
+#else
+  (void) name;
+  (void) core;
+  (void) priority;
+  (void) stack_size;
+  this->thread_ = std::thread(task_main, this);
+#endif
+  return true;
+}
+
+void WorkerTask::stop() {
+  if (!this->running_.exchange(false))
+    return;
+#ifdef ESP_PLATFORM
+  this->task_ = nullptr;
+#else
+  if (this->thread_.joinable())
+    this->thread_.join();
+#endif
+}
+
+void WorkerTask::sleep_ms(uint32_t ms) {
+#ifdef ESP_PLATFORM
+  vTaskDelay(pdMS_TO_TICKS(ms) > 0 ? pdMS_TO_TICKS(ms) : 1);
+#else
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
+
+void WorkerTask::task_main(void *arg) {
+  auto *self = static_cast<WorkerTask *>(arg);
+  while (self->running_.load(std::memory_order_relaxed))
+    self->body_();
+#ifdef ESP_PLATFORM
+  vTaskDelete(nullptr);
+#endif
+}
+
+}  // namespace realtime_fft
+}  // namespace esphome
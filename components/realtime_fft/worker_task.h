@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+namespace esphome {
+namespace realtime_fft {
+
+// Calls a function over and over on its own FreeRTOS task, pinned to a core,
+// until stopped. On hosts the task is a std::thread and the core is ignored.
+class WorkerTask {
+ public:
+  using Body = std::function<void()>;
+
+  ~WorkerTask() { this->stop(); }
+
+  bool start(Body body, const char *name, int core, int priority, uint32_t stack_size = 4096);
+  // On hosts this joins the thread; on ESP32 the task exits after its current
+  // iteration, so the object must outlive that iteration.
+  void stop();
+  bool is_running() const { return this->running_.load(std::memory_order_relaxed); }
+
+  // Yields the calling task for roughly ms milliseconds.
+  static void sleep_ms(uint32_t ms);
+
+ protected:
+  static void task_main(void *arg);
+
+  Body body_;
+  std::atomic<bool> running_{false};
+#ifdef ESP_PLATFORM
+  TaskHandle_t task_{nullptr};
+#else
+  std::thread thread_;
+#endif
+};
+
+}  // namespace realtime_fft
+}  // namespace esphome
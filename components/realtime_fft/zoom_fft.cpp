@@ -0,0 +1,221 @@
+#include "zoom_fft.h"
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace realtime_fft {
+
+template<typename T> static constexpr float full_scale() { return 1.0f; }
+template<> constexpr float full_scale<int16_t>() { return 1.0f / 32768.0f; }
+template<> constexpr float full_scale<int32_t>() { return 1.0f / 2147483648.0f; }
+
+// CIC input scaling: the mixed signal stays within +-2, so Q28 leaves 33 bits
+// for the 4 log2(R) bits of growth at R <= 256
+static constexpr float CIC_ONE = 268435456.0f;
+static constexpr size_t CIC_MAX_DECIMATION = 256;
+// FIR length per unit of its decimation; 24 gives about 70 dB of stopband
+static constexpr size_t FIR_TAPS_PER_PHASE = 24;
+
+// Magnitude response of the 4-stage CIC at f cycles per output sample
+static double cic_response(double f, size_t r) {
+  if (r == 1 || f == 0.0)
+    return 1.0;
+  const double ratio = std::sin(M_PI * f) / (r * std::sin(M_PI * f / r));
+  return ratio * ratio * ratio * ratio;
+}
+
+ZoomFFT::ZoomFFT(int sample_rate, size_t size, size_t hop_size, float center_frequency, size_t decimation)
+    : plan_(size) {
+  if (!this->plan_.is_valid() || sample_rate <= 0 || hop_size == 0 || hop_size > size || decimation < 2)
+    return;
+  // The FIR takes the last factor of 4 or 2; 3 and 5 are left to it alone
+  size_t fir = decimation % 4 == 0 ? 4 : decimation % 2 == 0 ? 2 : decimation;
+  if (fir > 5 || decimation / fir > CIC_MAX_DECIMATION)
+    return;
+  this->size_ = size;
+  this->hop_size_ = hop_size;
+  this->decimation_ = decimation;
+  this->fir_decimation_ = fir;
+  this->cic_decimation_ = decimation / fir;
+  this->center_frequency_ = center_frequency;
+  this->bin_width_ = static_cast<float>(sample_rate) / (decimation * size);
+
+  const double w = 2.0 * M_PI * center_frequency / sample_rate;
+  this->rotate_re_ = static_cast<float>(std::cos(w));
+  this->rotate_im_ = static_cast<float>(-std::sin(w));
+  const double r = static_cast<double>(this->cic_decimation_);
+  this->cic_gain_ = static_cast<float>(1.0 / (CIC_ONE * r * r * r * r));
+
+  // Frequency-sampling design in cycles per FIR input sample: flat up to 80%
+  // of the output Nyquist after undoing the CIC droop, zero from 120% on,
+  // linear in between, then a Blackman window
+  const size_t taps = FIR_TAPS_PER_PHASE * fir;
+  const double pass = 0.4 / fir, stop = 0.6 / fir;
+  const size_t grid = 8 * taps;
+  std::vector<double> response(grid);
+  for (size_t j = 0; j < grid; j++) {
+    const double f = (j + 0.5) * 0.5 / grid;
+    if (f <= pass) {
+      response[j] = 1.0 / cic_response(f, this->cic_decimation_);
+    } else if (f < stop) {
+      response[j] = (stop - f) / (stop - pass) / cic_response(pass, this->cic_decimation_);
+    }
+  }
+  this->taps_.resize(taps);
+  const double middle = 0.5 * (taps - 1);
+  double sum = 0.0;
+  for (size_t n = 0; n < taps; n++) {
+    // cos(2 pi f_j t) over the grid by the Chebyshev recurrence
+    const double t = n - middle;
+    const double step = 2.0 * std::cos(M_PI * t / grid);
+    double previous = std::cos(-0.5 * M_PI * t / grid), current = std::cos(0.5 * M_PI * t / grid);
+    double h = 0.0;
+    for (size_t j = 0; j < grid; j++) {
+      h += response[j] * current;
+      const double next = step * current - previous;
+      previous = current;
+      current = next;
+    }
+    const double x = 2.0 * M_PI * n / (taps - 1);
+    h *= 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+    this->taps_[n] = static_cast<float>(h);
+    sum += h;
+  }
+  // Unity gain at 0 Hz
+  for (float &tap : this->taps_)
+    tap = static_cast<float>(tap / sum);
+  this->fir_re_.resize(2 * taps);
+  this->fir_im_.resize(2 * taps);
+
+  this->ring_re_.resize(size);
+  this->ring_im_.resize(size);
+  this->window_.resize(size);
+  const float *hann = this->plan_.window();
+  for (size_t i = 0; i < size; i++)
+    this->window_[i] = (i & 1) ? -hann[i] : hann[i];
+  this->real_.resize(size);
+  this->imag_.resize(size);
+  this->reset();
+}
+
+size_t ZoomFFT::memory_bytes() const {
+  return this->plan_.memory_bytes() +
+         (this->taps_.size() + this->fir_re_.size() + this->fir_im_.size() + this->ring_re_.size() +
+          this->ring_im_.size() + this->window_.size() + this->real_.size() + this->imag_.size()) *
+             sizeof(float);
+}
+
+void ZoomFFT::reset() {
+  this->mix_re_ = 1.0f;
+  this->mix_im_ = 0.0f;
+  this->renormalise_ = 0;
+  std::fill_n(&this->integrators_[0][0], 8, 0);
+  std::fill_n(&this->combs_[0][0], 8, 0);
+  this->cic_phase_ = 0;
+  std::fill(this->fir_re_.begin(), this->fir_re_.end(), 0.0f);
+  std::fill(this->fir_im_.begin(), this->fir_im_.end(), 0.0f);
+  this->fir_position_ = 0;
+  this->fir_phase_ = 0;
+  this->ring_position_ = 0;
+  this->until_frame_ = this->size_;
+}
+
+void ZoomFFT::step_(float sample, const FrameCallback &callback, size_t &frames) {
+  // Twice the real input times e^(-i w n): the band lands at 0 Hz with the
+  // level of the one-sided real spectrum, its mirror image at -2w
+  const float re = 2.0f * sample * this->mix_re_;
+  const float im = 2.0f * sample * this->mix_im_;
+  const float rotated = this->mix_re_ * this->rotate_re_ - this->mix_im_ * this->rotate_im_;
+  this->mix_im_ = this->mix_re_ * this->rotate_im_ + this->mix_im_ * this->rotate_re_;
+  this->mix_re_ = rotated;
+  if (++this->renormalise_ == 256) {
+    // Keeps rounding from growing or shrinking the phasor
+    const float gain = 1.5f - 0.5f * (this->mix_re_ * this->mix_re_ + this->mix_im_ * this->mix_im_);
+    this->mix_re_ *= gain;
+    this->mix_im_ *= gain;
+    this->renormalise_ = 0;
+  }
+
+  if (this->cic_decimation_ == 1) {
+    this->fir_(re, im, callback, frames);
+    return;
+  }
+  const float parts[2] = {re, im};
+  for (size_t c = 0; c < 2; c++) {
+    uint64_t *s = this->integrators_[c];
+    s[0] += static_cast<uint64_t>(static_cast<int64_t>(parts[c] * CIC_ONE));
+    s[1] += s[0];
+    s[2] += s[1];
+    s[3] += s[2];
+  }
+  if (++this->cic_phase_ < this->cic_decimation_)
+    return;
+  this->cic_phase_ = 0;
+  float out[2];
+  for (size_t c = 0; c < 2; c++) {
+    uint64_t value = this->integrators_[c][3];
+    for (size_t j = 0; j < 4; j++) {
+      const uint64_t difference = value - this->combs_[c][j];
+      this->combs_[c][j] = value;
+      value = difference;
+    }
+    out[c] = static_cast<float>(static_cast<int64_t>(value)) * this->cic_gain_;
+  }
+  this->fir_(out[0], out[1], callback, frames);
+}
+
+void ZoomFFT::fir_(float re, float im, const FrameCallback &callback, size_t &frames) {
+  const size_t taps = this->taps_.size();
+  this->fir_re_[this->fir_position_] = this->fir_re_[this->fir_position_ + taps] = re;
+  this->fir_im_[this->fir_position_] = this->fir_im_[this->fir_position_ + taps] = im;
+  this->fir_position_ = this->fir_position_ + 1 == taps ? 0 : this->fir_position_ + 1;
+  if (++this->fir_phase_ < this->fir_decimation_)
+    return;
+  this->fir_phase_ = 0;
+
+  // The taps are symmetric, so the oldest-first window needs no reversal
+  const float *h = this->taps_.data();
+  const float *xr = this->fir_re_.data() + this->fir_position_;
+  const float *xi = this->fir_im_.data() + this->fir_position_;
+  float yr = 0.0f, yi = 0.0f;
+  for (size_t j = 0; j < taps; j++) {
+    yr += h[j] * xr[j];
+    yi += h[j] * xi[j];
+  }
+
+  this->ring_re_[this->ring_position_] = yr;
+  this->ring_im_[this->ring_position_] = yi;
+  this->ring_position_ = this->ring_position_ + 1 == this->size_ ? 0 : this->ring_position_ + 1;
+  if (--this->until_frame_ == 0) {
+    this->frame_(callback);
+    this->until_frame_ = this->hop_size_;
+    frames++;
+  }
+}
+
+void ZoomFFT::frame_(const FrameCallback &callback) {
+  // Oldest sample first, from the ring's write position
+  for (size_t i = 0; i < this->size_; i++) {
+    const size_t j = this->ring_position_ + i < this->size_ ? this->ring_position_ + i
+                                                            : this->ring_position_ + i - this->size_;
+    this->real_[i] = this->ring_re_[j] * this->window_[i];
+    this->imag_[i] = this->ring_im_[j] * this->window_[i];
+  }
+  this->plan_.forward(this->real_.data(), this->imag_.data());
+  callback(this->real_.data(), this->imag_.data());
+}
+
+template<typename T>
+size_t ZoomFFT::push(const T *samples, size_t count, size_t stride, const FrameCallback &callback) {
+  size_t frames = 0;
+  for (size_t i = 0; i < count; i += stride)
+    this->step_(samples[i] * full_scale<T>(), callback, frames);
+  return frames;
+}
+
+template size_t ZoomFFT::push<float>(const float *, size_t, size_t, const FrameCallback &);
+template size_t ZoomFFT::push<int16_t>(const int16_t *, size_t, size_t, const FrameCallback &);
+template size_t ZoomFFT::push<int32_t>(const int32_t *, size_t, size_t, const FrameCallback &);
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "fft_plan.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace esphome {
+namespace realtime_fft {
+
+// Zoom FFT: fine resolution over a narrow band around a centre frequency.
+//
+// The input is mixed down by the centre frequency with a rotating phasor, so
+// the band of interest sits around 0 Hz as a complex signal, then decimated
+// by a CIC filter (four integrator/comb pairs in wrapping 64-bit integers, so
+// they stay exact however long they run) followed by a FIR that decimates by
+// the last factor of 2 or 4 and flattens the CIC's passband droop. The FIR is
+// only evaluated at its output instants, i.e. in polyphase form.
+//
+// Frames of size() decimated samples then go through a complex FFT, giving
+// size() bins that span sample_rate / decimation centred on the centre
+// frequency, ordered from low to high: bin k is at
+// centre + (k - size()/2) * sample_rate / (decimation * size()). The
+// reordering comes for free from alternating the sign of the window. Bin
+// levels use the same scale as FFTPlan's windowed real transform of
+// 2 * size() samples, so a tone reads the same in both.
+//
+// The FIR passes the inner 80% of the band flat; the outer 10% on each side
+// can hold energy aliased from just outside the band.
+class ZoomFFT {
+ public:
+  // Called with the size() complex bins of every frame
+  using FrameCallback = std::function<void(const float *real, const float *imag)>;
+
+  // hop_size counts decimated samples, up to size
+  ZoomFFT(int sample_rate, size_t size, size_t hop_size, float center_frequency, size_t decimation);
+
+  bool is_valid() const { return this->size_ != 0; }
+  size_t size() const { return this->size_; }
+  size_t decimation() const { return this->decimation_; }
+  size_t cic_decimation() const { return this->cic_decimation_; }
+  size_t fir_taps() const { return this->taps_.size(); }
+  float center_frequency() const { return this->center_frequency_; }
+  float bin_width() const { return this->bin_width_; }
+  // Frequency of (fractional) bin k
+  float frequency(float bin) const { return this->center_frequency_ + (bin - this->size_ / 2) * this->bin_width_; }
+  // Heap bytes held by the tables, filter state and frame buffers
+  size_t memory_bytes() const;
+
+  // Feeds count samples, taking every stride-th one (channel 0 of interleaved
+  // input), and invokes the callback per completed frame. Integer samples are
+  // scaled so that full scale is 1.0. Returns the number of frames.
+  template<typename T> size_t push(const T *samples, size_t count, size_t stride, const FrameCallback &callback);
+
+  // Clears the filters and the frame; the next frame needs size() new outputs.
+  void reset();
+
+ protected:
+  void step_(float sample, const FrameCallback &callback, size_t &frames);
+  void fir_(float re, float im, const FrameCallback &callback, size_t &frames);
+  void frame_(const FrameCallback &callback);
+
+  size_t size_{0};
+  size_t hop_size_{0};
+  size_t decimation_{0};
+  size_t cic_decimation_{1};
+  size_t fir_decimation_{1};
+  float center_frequency_{0.0f};
+  float bin_width_{0.0f};
+  FFTPlan plan_;
+
+  // Mixer phasor e^(-i w n) and its step; renormalised now and then
+  float mix_re_{1.0f};
+  float mix_im_{0.0f};
+  float rotate_re_{1.0f};
+  float rotate_im_{0.0f};
+  uint32_t renormalise_{0};
+
+  // CIC integrators and comb delays, real and imaginary, in Q28 wrapping
+  // arithmetic; gain_ undoes both the Q28 scaling and the R^4 CIC gain
+  uint64_t integrators_[2][4];
+  uint64_t combs_[2][4];
+  size_t cic_phase_{0};
+  float cic_gain_{1.0f};
+
+  // Decimating FIR: taps, and the last taps inputs stored twice so the newest
+  // taps samples are always contiguous
+  std::vector<float> taps_;
+  std::vector<float> fir_re_;
+  std::vector<float> fir_im_;
+  size_t fir_position_{0};
+  size_t fir_phase_{0};
+
+  // The last size() decimated samples, and the frame being transformed
+  std::vector<float> ring_re_;
+  std::vector<float> ring_im_;
+  size_t ring_position_{0};
+  size_t until_frame_{0};
+  // Hann window with every other sign flipped, which centres the band
+  std::vector<float> window_;
+  std::vector<float> real_;
+  std::vector<float> imag_;
+};
+
+extern template size_t ZoomFFT::push<float>(const float *, size_t, size_t, const FrameCallback &);
+extern template size_t ZoomFFT::push<int16_t>(const int16_t *, size_t, size_t, const FrameCallback &);
+extern template size_t ZoomFFT::push<int32_t>(const int32_t *, size_t, size_t, const FrameCallback &);
+
+}  // namespace realtime_fft
+}  // namespace esphome
@@ -4,34 +4,142 @@
 #include <vector>
 #include <complex>
 #include <cmath>
+#include <functional>
+#include <memory>
+#include "realtime_fft/multi_channel_fft.h"
+#include "realtime_fft/peak_finder.h"
+#include "realtime_fft/sliding_dft.h"
+#include "realtime_fft/spectrogram_history.h"
+#include "realtime_fft/spectrum_format.h"
+#include "realtime_fft/spectrum_view.h"
+#include "realtime_fft/stft_framer.h"
 
 class RealtimeFFT {
 public:
-    RealtimeFFT(int fftSize = 1024);
+    // Called after every frame produced by pushAudioData
+    using FrameCallback = std::function<void(const RealtimeFFT&)>;
+
+    // Called in sliding mode when the magnitude at a sliding frequency rises
+    // above the trigger threshold; sampleOffset is the sample (per channel)
+    // within the chunk given to pushAudioData
+    using TriggerCallback = std::function<void(const RealtimeFFT&, int frequency, size_t sampleOffset)>;
+
+    // hopSize is the streaming frame advance; 0 means fftSize (no overlap).
+    // With several channels, input is interleaved and every frame transforms
+    // all of them through one shared plan. fftSize may be any even size: powers
+    // of two use radix-4 passes, others mixed-radix or Bluestein transforms.
+    RealtimeFFT(int fftSize = 1024, int hopSize = 0, int channels = 1, float sampleRate = 44100.0f);
     
+    using SpectrumView = esphome::realtime_fft::SpectrumView;
+    using SpectrumScale = esphome::realtime_fft::SpectrumScale;
+    using HistoryDepth = esphome::realtime_fft::HistoryDepth;
+    using SpectrogramHistory = esphome::realtime_fft::SpectrogramHistory;
+
     // Process audio data and compute FFT
     void processAudioData(const std::vector<float>& audioInput);
+
+    // Same as processAudioData, straight from a caller buffer (e.g. DMA); count is
+    // fftSize samples per channel. Single-channel input is used without a copy.
+    void process(const float* samples, size_t count);
+
+    // Stream audio in chunks of any size; a spectrum is computed every hopSize
+    // samples once the first full frame is buffered. Returns the frame count.
+    size_t pushAudioData(const float* samples, size_t count);
+
+    // Set the callback invoked for every streamed frame
+    void setFrameCallback(FrameCallback callback);
+
+    // Drop buffered streaming samples
+    void resetStream();
+
+    // Sliding mode: instead of computing frames, pushAudioData updates the
+    // Hann-windowed DFT of the last fftSize samples (channel 0) at these
+    // frequencies on every sample. damping, just below 1, keeps it stable.
+    // An empty list goes back to frame mode.
+    void setSlidingFrequencies(const std::vector<float>& frequencies, float damping = 0.99999f);
+
+    // Report sliding magnitudes crossing threshold upwards, to the sample;
+    // frequencies already above it when the callback is set count as a crossing
+    void setTrigger(float threshold, TriggerCallback callback);
+
+    // Current magnitudes at the sliding frequencies
+    std::vector<float> getSlidingMagnitudes() const;
     
-    // Get magnitude spectrum
+    int getChannelCount() const { return m_channels; }
+    float getSampleRate() const { return m_sampleRate; }
+
+    // Transform used for this size: a radix-4 kernel name, "mixed_radix" or "bluestein"
+    const char* getAlgorithm() const { return m_fft.plan().kernel_name(); }
+
+    // What the spectrum bins hold from the next frame on: magnitude (the
+    // default), power with no square roots, or dB relative to reference
+    // and clamped at floorDb. The conversion runs in the transform's last pass.
+    void setSpectrumFormat(SpectrumScale scale, float reference = 1.0f, float floorDb = -120.0f);
+
+    // Get the spectrum, fftSize/2 bins per channel one after the other
     std::vector<float> getMagnitudeSpectrum() const;
+
+    // Copy the spectrum into out; returns the number of bins written
+    size_t getMagnitudeSpectrum(float* out, size_t capacity) const;
+
+    // Read-only view of the spectrum, valid until the next frame
+    SpectrumView magnitudes() const;
+
+    // Same, for one channel
+    SpectrumView magnitudes(int channel) const;
     
+    // Keep the last frames spectra of channel 0 quantised to dB (8 bits from
+    // floorDb to floorDb + rangeDb, or 4 bits scaled per frame); timestamps
+    // count frames since the history was set. 0 frames turns it off.
+    void setHistory(size_t frames, HistoryDepth depth = esphome::realtime_fft::HISTORY_8BIT,
+                    float floorDb = -40.0f, float rangeDb = 120.0f);
+
+    // Spectrogram history, null unless enabled; slices stay valid until the next frame
+    const SpectrogramHistory* history() const { return m_history.get(); }
+
     // Get frequency bins
     std::vector<float> getFrequencyBins() const;
+
+    // Read-only view of the bin frequencies
+    SpectrumView frequencyBins() const;
     
-    // Compute peak frequencies
-    std::vector<float> findPeakFrequencies(int numPeaks = 5) const;
+    // Frequencies of the strongest spectral peaks, strongest first, interpolated
+    // to sub-bin accuracy. Maxima closer than minSpacing bins count as one peak.
+    std::vector<float> findPeakFrequencies(int numPeaks = 5, int minSpacing = 2, int channel = 0) const;
 
 private:
+    // Throws std::invalid_argument for arguments the members can't be built
+    // from; runs first in the initializer list, before anything is allocated
+    static int validatedFftSize(int fftSize, int hopSize, int channels, float sampleRate);
+
     int m_fftSize;
-    std::vector<std::complex<float>> m_complexBuffer;
+    int m_channels;
+    float m_sampleRate;
+    // Twiddle, bit-reversal and window tables, built once in the constructor and
+    // shared by all channels; keeps bins 0..fftSize/2 of every channel
+    esphome::realtime_fft::MultiChannelFFT m_fft;
+    esphome::realtime_fft::SpectrumFormat m_format;
+    // Ring buffer that slices streamed audio into overlapping, de-interleaved frames
+    esphome::realtime_fft::StftFramer<float> m_framer;
+    FrameCallback m_frameCallback;
+    // Sliding mode state, null in frame mode
+    std::unique_ptr<esphome::realtime_fft::SlidingDFT> m_sliding;
+    float m_triggerThreshold = 0.0f;
+    TriggerCallback m_triggerCallback;
+    // Whether each sliding frequency was above the threshold after the last sample
+    std::vector<bool> m_triggered;
+    std::unique_ptr<SpectrogramHistory> m_history;
+    uint32_t m_historyFrames = 0;
+    // Planar copy of interleaved input passed to process()
+    std::vector<float> m_frame;
     std::vector<float> m_magnitudeSpectrum;
     std::vector<float> m_frequencyBins;
 
-    // Perform Cooley-Tukey FFT
-    void cooleyTukeyFFT(std::vector<std::complex<float>>& data);
-    
-    // Bit reversal for FFT
-    void bitReversalPermutation(std::vector<std::complex<float>>& data);
+    // Window, transform and format the spectrum of one planar frame
+    void processFrame(const float* frame);
+
+    // Sliding mode part of pushAudioData
+    void pushSliding(const float* samples, size_t count);
 };
 
 #endif // REALTIME_FFT_H
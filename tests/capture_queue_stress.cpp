@@ -0,0 +1,164 @@
+// Stress test for the capture queue: a producer thread against a consumer, as
+// the capture task and the FFT task run on the device.
+//
+// The SPSC ring gets sequence numbers pushed and popped in unrelated chunk
+// sizes, with a capacity small enough that both sides keep hitting the full
+// and empty cases; every element must come out once and in order. The capture
+// task is then driven by a synthetic read function against a consumer that
+// stalls now and then, so whole chunks are dropped: what arrives must still be
+// whole chunks in order, and chunks received plus overruns must account for
+// every chunk produced. Build with -DREALTIME_FFT_SANITIZE=thread to have
+// ThreadSanitizer check the memory ordering too.
+
+#include "realtime_fft/capture_task.h"
+#include "realtime_fft/spsc_ring_buffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace esphome::realtime_fft;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+  do { \
+    if (!(cond)) { \
+      std::fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+      std::fprintf(stderr, __VA_ARGS__); \
+      std::fprintf(stderr, "\n"); \
+      failures++; \
+    } \
+  } while (0)
+
+// xorshift32, so chunk sizes differ between the two sides but not between runs
+static uint32_t next_random(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static void ring_order() {
+  const size_t total = 2000000;
+  SpscRingBuffer<uint32_t> ring(1000);
+
+  std::thread producer([&ring]() {
+    uint32_t state = 1;
+    std::vector<uint32_t> chunk(97);
+    size_t sent = 0;
+    while (sent < total) {
+      const size_t count = std::min<size_t>(1 + next_random(state) % chunk.size(), total - sent);
+      for (size_t i = 0; i < count; i++)
+        chunk[i] = static_cast<uint32_t>(sent + i);
+      while (!ring.push(chunk.data(), count))
+        std::this_thread::yield();
+      sent += count;
+    }
+  });
+
+  uint32_t state = 7;
+  std::vector<uint32_t> chunk(131);
+  size_t received = 0;
+  size_t errors = 0;
+  while (received < total) {
+    const size_t count = std::min<size_t>(1 + next_random(state) % chunk.size(), total - received);
+    if (!ring.pop(chunk.data(), count)) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (size_t i = 0; i < count; i++) {
+      if (chunk[i] != static_cast<uint32_t>(received + i) && errors++ == 0)
+        CHECK(false, "ring: element %zu is %u", received + i, chunk[i]);
+    }
+    received += count;
+  }
+  producer.join();
+  CHECK(errors == 0, "ring: %zu elements out of order", errors);
+  CHECK(ring.available() == 0, "ring: %zu elements left over", ring.available());
+  std::printf("ring: %zu elements in order through a %zu-element buffer\n", received, ring.capacity());
+}
+
+static void capture_task_accounting() {
+  const size_t words = 64;
+  const size_t chunk_bytes = words * sizeof(uint32_t);
+  const uint32_t total_chunks = 50000;
+  CaptureTask capture(16 * chunk_bytes, chunk_bytes);
+
+  // Chunk k carries the words k * words .. k * words + words - 1
+  std::atomic<uint32_t> produced{0};
+  capture.start([&produced](uint8_t *dst, size_t max_bytes) -> size_t {
+    const uint32_t k = produced.load(std::memory_order_relaxed);
+    if (k == total_chunks || max_bytes < words * sizeof(uint32_t))
+      return 0;
+    for (size_t i = 0; i < words; i++) {
+      const uint32_t word = static_cast<uint32_t>(k * words + i);
+      std::memcpy(dst + i * sizeof(uint32_t), &word, sizeof(word));
+    }
+    produced.store(k + 1, std::memory_order_release);
+    // Block now and then, the way a DMA read waits for the next buffer
+    if (k % 16 == 15)
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    return words * sizeof(uint32_t);
+  });
+
+  uint32_t state = 3;
+  std::vector<uint8_t> chunk(chunk_bytes);
+  uint32_t received = 0;
+  size_t bytes = 0;
+  int64_t last = -1;
+  size_t errors = 0;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (!capture.buffer().pop(chunk.data(), chunk.size())) {
+      // Every chunk produced has been pushed or counted once the producer is
+      // done and the ring is empty
+      const bool done = produced.load(std::memory_order_acquire) == total_chunks;
+      if (done && received + capture.get_overruns() == total_chunks)
+        break;
+      std::this_thread::yield();
+      continue;
+    }
+    received++;
+    bytes += chunk.size();
+    uint32_t first;
+    std::memcpy(&first, chunk.data(), sizeof(first));
+    if (first % words != 0 || static_cast<int64_t>(first / words) <= last) {
+      if (errors++ == 0)
+        CHECK(false, "capture: chunk starting at word %u after chunk %lld", first, static_cast<long long>(last));
+    }
+    last = first / words;
+    for (size_t i = 1; i < words; i++) {
+      uint32_t word;
+      std::memcpy(&word, chunk.data() + i * sizeof(uint32_t), sizeof(word));
+      if (word != first + i && errors++ == 0)
+        CHECK(false, "capture: word %zu of chunk %zu is %u", i, static_cast<size_t>(first / words), word);
+    }
+    // Stall now and then, the way a slow frame would, so the producer overruns
+    if (next_random(state) % 64 == 0)
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  capture.stop();
+
+  const uint32_t overruns = capture.get_overruns();
+  CHECK(errors == 0, "capture: %zu chunks out of order or torn", errors);
+  CHECK(received + overruns == total_chunks, "capture: %u received + %u overruns != %u produced", received, overruns,
+        total_chunks);
+  CHECK(bytes == static_cast<size_t>(received) * chunk_bytes, "capture: %zu bytes for %u chunks", bytes, received);
+  std::printf("capture: %u chunks produced, %u received (%zu bytes), %u overruns\n", total_chunks, received, bytes,
+              overruns);
+}
+
+int main() {
+  ring_order();
+  capture_task_accounting();
+  if (failures != 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
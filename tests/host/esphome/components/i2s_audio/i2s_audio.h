@@ -0,0 +1,17 @@
+#pragma once
+
+// Host stand-in for the i2s_audio component. There is no I2S on a host, so
+// the realtime_fft component needs an explicit audio source there.
+
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace i2s_audio {
+
+class I2SAudioComponent : public Component {
+ public:
+  int get_port() const { return 0; }
+};
+
+}  // namespace i2s_audio
+}  // namespace esphome
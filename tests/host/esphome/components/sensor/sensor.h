@@ -0,0 +1,30 @@
+#pragma once
+
+// Host stand-in for ESPHome's Sensor: keeps the last state and calls the
+// state callbacks, which is what host tests observe the component through.
+
+#include "esphome/core/component.h"
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+namespace sensor {
+
+class Sensor {
+ public:
+  void publish_state(float state) {
+    this->state = state;
+    for (auto &callback : this->callbacks_)
+      callback(state);
+  }
+  void add_on_state_callback(std::function<void(float)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+
+  float state{0.0f};
+
+ protected:
+  std::vector<std::function<void(float)>> callbacks_;
+};
+
+}  // namespace sensor
+}  // namespace esphome
@@ -0,0 +1,62 @@
+#pragma once
+
+// Host stand-in for the parts of ESPHome's Component the realtime_fft
+// component uses, so its own setup() and loop() can run in host tests.
+
+#include "esphome/core/hal.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+
+namespace setup_priority {
+const float HARDWARE = 800.0f;
+const float DATA = 600.0f;
+}  // namespace setup_priority
+
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+
+  // What the application does every main loop iteration: loop(), then the
+  // intervals that are due
+  void call_loop() {
+    if (this->failed_)
+      return;
+    this->loop();
+    const uint32_t now = millis();
+    for (Interval &interval : this->intervals_) {
+      if (now - interval.last < interval.interval_ms)
+        continue;
+      interval.last = now;
+      interval.callback();
+    }
+  }
+
+ protected:
+  struct Interval {
+    std::string name;
+    uint32_t interval_ms;
+    uint32_t last;
+    std::function<void()> callback;
+  };
+
+  void set_interval(const std::string &name, uint32_t interval_ms, std::function<void()> &&callback) {
+    this->intervals_.push_back({name, interval_ms, millis(), std::move(callback)});
+  }
+
+  bool failed_{false};
+  std::vector<Interval> intervals_;
+};
+
+}  // namespace esphome
@@ -0,0 +1,24 @@
+#pragma once
+
+// Host stand-in for ESPHome's HAL timing functions, on the steady clock.
+
+#include <chrono>
+#include <cstdint>
+
+namespace esphome {
+
+inline uint32_t micros() {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+inline uint32_t millis() { return micros() / 1000; }
+// A 1 GHz "cycle counter", so cycle-based statistics come out in nanoseconds
+inline uint32_t arch_get_cpu_freq_hz() { return 1000000000; }
+inline uint32_t arch_get_cpu_cycle_count() {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+}  // namespace esphome
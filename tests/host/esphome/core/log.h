@@ -0,0 +1,31 @@
+#pragma once
+
+// Host stand-in for ESPHome's logger: errors and warnings go to stderr,
+// everything else to stdout unless REALTIME_FFT_HOST_QUIET is defined.
+
+#include <cstdio>
+
+#define ESP_HOST_LOG_(stream, level, tag, ...) \
+  do { \
+    std::fprintf(stream, "[%s][%s] ", level, tag); \
+    std::fprintf(stream, __VA_ARGS__); \
+    std::fprintf(stream, "\n"); \
+  } while (0)
+
+#define ESP_LOGE(tag, ...) ESP_HOST_LOG_(stderr, "E", tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESP_HOST_LOG_(stderr, "W", tag, __VA_ARGS__)
+// Disabled levels still see their arguments, so nothing logged goes unused
+#define ESP_HOST_LOG_OFF_(tag, ...) \
+  do { \
+    if (false) \
+      ESP_HOST_LOG_(stdout, "D", tag, __VA_ARGS__); \
+  } while (0)
+
+#ifdef REALTIME_FFT_HOST_QUIET
+#define ESP_LOGI ESP_HOST_LOG_OFF_
+#else
+#define ESP_LOGI(tag, ...) ESP_HOST_LOG_(stdout, "I", tag, __VA_ARGS__)
+#endif
+#define ESP_LOGCONFIG ESP_LOGI
+#define ESP_LOGD ESP_HOST_LOG_OFF_
+#define ESP_LOGV ESP_HOST_LOG_OFF_
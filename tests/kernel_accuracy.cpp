@@ -0,0 +1,200 @@
+// Checks every radix-4 kernel the host CPU supports against the scalar one.
+//
+// Each power-of-two plan transforms the same random complex frames once per
+// kernel, and every kernel must produce exactly the scalar kernel's bits: the
+// vector kernels do the same multiplies and adds lane by lane, without FMA.
+// The scalar plan must in turn produce exactly the bits of a plain table-driven
+// radix-2 transform, since each radix-4 pass fuses two radix-2 stages without
+// changing their arithmetic, and is checked against a double-precision DFT, so
+// the reference itself is known to be right.
+
+#include "realtime_fft/fft_kernels.h"
+#include "realtime_fft/fft_plan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace esphome::realtime_fft;
+
+// Largest allowed difference of the scalar kernel from the double-precision DFT
+static const double DFT_TOLERANCE = 1e-5;
+
+static int failures = 0;
+
+static uint32_t next_random(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static void random_frame(uint32_t &state, std::vector<float> &real, std::vector<float> &imag) {
+  for (size_t i = 0; i < real.size(); i++) {
+    real[i] = static_cast<float>(next_random(state)) / 2147483648.0f - 1.0f;
+    imag[i] = static_cast<float>(next_random(state)) / 2147483648.0f - 1.0f;
+  }
+}
+
+static double largest_bin(const std::vector<float> &real, const std::vector<float> &imag) {
+  double largest = 0.0;
+  for (size_t i = 0; i < real.size(); i++)
+    largest = std::max(largest, std::hypot(static_cast<double>(real[i]), static_cast<double>(imag[i])));
+  return largest;
+}
+
+static void check_against_dft(FFTPlan &plan, uint32_t &state) {
+  const size_t n = plan.size();
+  std::vector<float> real(n), imag(n);
+  random_frame(state, real, imag);
+  const std::vector<float> in_real = real, in_imag = imag;
+  plan.set_kernel(radix4_scalar_kernel());
+  plan.forward(real.data(), imag.data());
+
+  double error = 0.0;
+  for (size_t k = 0; k < n; k++) {
+    double sr = 0.0, si = 0.0;
+    for (size_t t = 0; t < n; t++) {
+      const double phase = -2.0 * M_PI * static_cast<double>((k * t) % n) / static_cast<double>(n);
+      sr += in_real[t] * std::cos(phase) - in_imag[t] * std::sin(phase);
+      si += in_real[t] * std::sin(phase) + in_imag[t] * std::cos(phase);
+    }
+    error = std::max(error, std::hypot(real[k] - sr, imag[k] - si));
+  }
+  error /= largest_bin(real, imag);
+  if (error > DFT_TOLERANCE) {
+    std::fprintf(stderr, "FAIL size %zu: scalar kernel is %.3g off the DFT (tolerance %.3g)\n", n, error,
+                 DFT_TOLERANCE);
+    failures++;
+  }
+}
+
+static bool same_bits(const std::vector<float> &a, const std::vector<float> &b) {
+  return std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+static size_t differing_bins(const std::vector<float> &real, const std::vector<float> &imag,
+                             const std::vector<float> &ref_real, const std::vector<float> &ref_imag) {
+  size_t differing = 0;
+  for (size_t k = 0; k < real.size(); k++) {
+    if (std::memcmp(&real[k], &ref_real[k], sizeof(float)) != 0 ||
+        std::memcmp(&imag[k], &ref_imag[k], sizeof(float)) != 0)
+      differing++;
+  }
+  return differing;
+}
+
+// Decimation-in-time radix-2 transform, one stage per pass, with the stage
+// tables laid out and rounded as FFTPlan builds them
+static void radix2_reference(std::vector<float> &real, std::vector<float> &imag) {
+  const size_t n = real.size();
+  std::vector<float> wr(n - 1), wi(n - 1);
+  for (size_t h = 1; h < n; h *= 2) {
+    for (size_t j = 0; j < h; j++) {
+      const double theta = -M_PI * j / h;
+      const bool quarter = 2 * j == h;
+      wr[h - 1 + j] = quarter ? 0.0f : static_cast<float>(std::cos(theta));
+      wi[h - 1 + j] = quarter ? -1.0f : static_cast<float>(std::sin(theta));
+    }
+  }
+
+  int bits = 0;
+  while ((size_t(1) << bits) < n)
+    bits++;
+  for (size_t i = 0; i < n; i++) {
+    size_t rev = 0;
+    for (int b = 0; b < bits; b++)
+      rev |= ((i >> b) & 1) << (bits - 1 - b);
+    if (i < rev) {
+      std::swap(real[i], real[rev]);
+      std::swap(imag[i], imag[rev]);
+    }
+  }
+
+  for (size_t h = 1; h < n; h *= 2) {
+    for (size_t k = 0; k < n; k += 2 * h) {
+      for (size_t j = 0; j < h; j++) {
+        const size_t a = k + j, b = a + h;
+        const float tr = wr[h - 1 + j] * real[b] - wi[h - 1 + j] * imag[b];
+        const float ti = wr[h - 1 + j] * imag[b] + wi[h - 1 + j] * real[b];
+        real[b] = real[a] - tr;
+        imag[b] = imag[a] - ti;
+        real[a] += tr;
+        imag[a] += ti;
+      }
+    }
+  }
+}
+
+static void check_against_radix2(FFTPlan &plan, uint32_t &state) {
+  const size_t n = plan.size();
+  std::vector<float> real(n), imag(n);
+  random_frame(state, real, imag);
+  std::vector<float> ref_real = real, ref_imag = imag;
+  radix2_reference(ref_real, ref_imag);
+  plan.set_kernel(radix4_scalar_kernel());
+  plan.forward(real.data(), imag.data());
+  if (!same_bits(real, ref_real) || !same_bits(imag, ref_imag)) {
+    std::fprintf(stderr, "FAIL size %zu: scalar kernel differs from the radix-2 reference in %zu bins\n", n,
+                 differing_bins(real, imag, ref_real, ref_imag));
+    failures++;
+  }
+}
+
+static void check_kernels(FFTPlan &plan, const std::vector<Radix4Kernel> &kernels, uint32_t &state) {
+  const size_t n = plan.size();
+  std::vector<float> in_real(n), in_imag(n);
+  std::vector<float> ref_real, ref_imag, real, imag;
+  for (int frame = 0; frame < 4; frame++) {
+    random_frame(state, in_real, in_imag);
+    ref_real = in_real;
+    ref_imag = in_imag;
+    plan.set_kernel(radix4_scalar_kernel());
+    plan.forward(ref_real.data(), ref_imag.data());
+
+    for (const Radix4Kernel &kernel : kernels) {
+      real = in_real;
+      imag = in_imag;
+      plan.set_kernel(kernel);
+      plan.forward(real.data(), imag.data());
+      if (!same_bits(real, ref_real) || !same_bits(imag, ref_imag)) {
+        std::fprintf(stderr, "FAIL size %zu: %s kernel differs from scalar in %zu bins\n", n, kernel.name,
+                     differing_bins(real, imag, ref_real, ref_imag));
+        failures++;
+      }
+    }
+  }
+}
+
+int main() {
+  const std::vector<Radix4Kernel> kernels = available_radix4_kernels();
+  std::printf("kernels:");
+  for (const Radix4Kernel &kernel : kernels)
+    std::printf(" %s", kernel.name);
+  std::printf("\n");
+
+  uint32_t state = 1;
+  for (size_t n = 2; n <= 16384; n *= 2) {
+    FFTPlan plan(n);
+    if (!plan.is_valid() || !plan.is_power_of_two()) {
+      std::fprintf(stderr, "FAIL size %zu: no radix-4 plan\n", n);
+      failures++;
+      continue;
+    }
+    check_against_radix2(plan, state);
+    if (n <= 1024)
+      check_against_dft(plan, state);
+    check_kernels(plan, kernels, state);
+  }
+
+  if (failures != 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  std::printf("all kernels bit-identical to scalar and to the radix-2 reference\n");
+  return 0;
+}
@@ -0,0 +1,150 @@
+// Checks the transforms for sizes that aren't a power of two against a
+// double-precision DFT.
+//
+// MixedRadixFFT runs 2/3/5-smooth lengths as a mixed-radix transform and every
+// other length through Bluestein; both must match the DFT of the same random
+// complex frame to within DFT_TOLERANCE of its largest bin. FFTPlan is then
+// checked on the same sizes through its complex forward() and its real path,
+// forward_real(), with and without the Hann window, which pack the even size
+// into a half-size mixed-radix or Bluestein transform.
+
+#include "realtime_fft/fft_plan.h"
+#include "realtime_fft/mixed_radix_fft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace esphome::realtime_fft;
+
+// Largest allowed difference from the DFT, relative to the largest bin
+static const double DFT_TOLERANCE = 1e-5;
+
+static int failures = 0;
+
+static uint32_t next_random(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static float random_sample(uint32_t &state) { return static_cast<float>(next_random(state)) / 2147483648.0f - 1.0f; }
+
+// Bins 0..bins-1 of the DFT of n complex points, in double precision
+static void dft(const std::vector<float> &in_real, const std::vector<float> &in_imag, size_t bins,
+                std::vector<double> &real, std::vector<double> &imag) {
+  const size_t n = in_real.size();
+  std::vector<double> cos_table(n), sin_table(n);
+  for (size_t i = 0; i < n; i++) {
+    cos_table[i] = std::cos(2.0 * M_PI * i / n);
+    sin_table[i] = std::sin(2.0 * M_PI * i / n);
+  }
+  real.assign(bins, 0.0);
+  imag.assign(bins, 0.0);
+  for (size_t k = 0; k < bins; k++) {
+    size_t idx = 0;
+    for (size_t t = 0; t < n; t++) {
+      // x * exp(-2 pi i k t / n)
+      real[k] += in_real[t] * cos_table[idx] + in_imag[t] * sin_table[idx];
+      imag[k] += in_imag[t] * cos_table[idx] - in_real[t] * sin_table[idx];
+      idx += k;
+      if (idx >= n)
+        idx -= n;
+    }
+  }
+}
+
+// Largest difference from the DFT over its bins, relative to its largest bin
+static double dft_error(const float *real, const float *imag, const std::vector<double> &ref_real,
+                        const std::vector<double> &ref_imag) {
+  double error = 0.0, largest = 0.0;
+  for (size_t k = 0; k < ref_real.size(); k++) {
+    error = std::max(error, std::hypot(real[k] - ref_real[k], imag[k] - ref_imag[k]));
+    largest = std::max(largest, std::hypot(ref_real[k], ref_imag[k]));
+  }
+  return error / largest;
+}
+
+static void report(const char *what, size_t n, const char *name, double error) {
+  if (error > DFT_TOLERANCE) {
+    std::fprintf(stderr, "FAIL size %zu: %s (%s) is %.3g off the DFT (tolerance %.3g)\n", n, what, name, error,
+                 DFT_TOLERANCE);
+    failures++;
+  }
+}
+
+static void check_mixed_radix(size_t n, uint32_t &state) {
+  MixedRadixFFT fft(n);
+  if (!fft.is_valid() || fft.is_bluestein() == MixedRadixFFT::is_smooth(n)) {
+    std::fprintf(stderr, "FAIL size %zu: no %s transform\n", n,
+                 MixedRadixFFT::is_smooth(n) ? "mixed-radix" : "Bluestein");
+    failures++;
+    return;
+  }
+  std::vector<float> real(n), imag(n);
+  for (size_t i = 0; i < n; i++) {
+    real[i] = random_sample(state);
+    imag[i] = random_sample(state);
+  }
+  std::vector<double> ref_real, ref_imag;
+  dft(real, imag, n, ref_real, ref_imag);
+  fft.forward(real.data(), imag.data());
+  report("MixedRadixFFT", n, fft.name(), dft_error(real.data(), imag.data(), ref_real, ref_imag));
+}
+
+static void check_plan(size_t n, uint32_t &state) {
+  FFTPlan plan(n);
+  if (!plan.is_valid() || plan.is_power_of_two()) {
+    std::fprintf(stderr, "FAIL size %zu: no mixed-radix plan\n", n);
+    failures++;
+    return;
+  }
+  std::vector<double> ref_real, ref_imag;
+
+  std::vector<float> real(n), imag(n);
+  for (size_t i = 0; i < n; i++) {
+    real[i] = random_sample(state);
+    imag[i] = random_sample(state);
+  }
+  dft(real, imag, n, ref_real, ref_imag);
+  plan.forward(real.data(), imag.data());
+  report("FFTPlan::forward", n, plan.kernel_name(), dft_error(real.data(), imag.data(), ref_real, ref_imag));
+
+  // Real path: bins 0..n/2 inclusive
+  std::vector<float> in(n), windowed(n), zeros(n, 0.0f);
+  for (size_t i = 0; i < n; i++)
+    in[i] = random_sample(state);
+  std::vector<float> out_real(n / 2 + 1), out_imag(n / 2 + 1);
+  dft(in, zeros, n / 2 + 1, ref_real, ref_imag);
+  plan.forward_real(in.data(), out_real.data(), out_imag.data());
+  report("FFTPlan::forward_real", n, plan.kernel_name(),
+         dft_error(out_real.data(), out_imag.data(), ref_real, ref_imag));
+
+  for (size_t i = 0; i < n; i++)
+    windowed[i] = static_cast<float>(in[i] * 0.5 * (1.0 - std::cos(2.0 * M_PI * i / (n - 1))));
+  dft(windowed, zeros, n / 2 + 1, ref_real, ref_imag);
+  plan.forward_real(in.data(), out_real.data(), out_imag.data(), true);
+  report("windowed FFTPlan::forward_real", n, plan.kernel_name(),
+         dft_error(out_real.data(), out_imag.data(), ref_real, ref_imag));
+}
+
+int main() {
+  uint32_t state = 1;
+  // Smooth lengths, then lengths with a prime factor above 5, down to primes
+  for (size_t n : {6, 9, 10, 12, 15, 25, 30, 80, 160, 240, 480, 500, 960, 1000, 1440, 7, 14, 22, 49, 97, 499, 998})
+    check_mixed_radix(n, state);
+  // Even sizes whose half is smooth (16/48 kHz blocks), then ones whose half
+  // goes through Bluestein
+  for (size_t n : {12, 160, 320, 480, 960, 1000, 1920, 14, 44, 194, 998})
+    check_plan(n, state);
+
+  if (failures != 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  std::printf("mixed-radix, Bluestein and FFTPlan within %.3g of the DFT\n", DFT_TOLERANCE);
+  return 0;
+}
@@ -0,0 +1,189 @@
+// Replays a recorded WAV (or headerless PCM) file through the realtime_fft
+// component on a host.
+//
+//   pcm_replay [--fft-size 1024] [--hop-size 512] [--channels 1] [--first-channel 0]
+//              [--precision float|q15|q31] [--expect CHANNEL:HZ]... file.wav
+//
+// The file goes in through PcmFileSource, set as the component's audio
+// source, and the component runs its own setup() and loop(): capture task,
+// queue, framer, engines and publishing are the ones the device runs, built
+// against the host stand-ins for ESPHome in tests/host. The file is read as
+// fast as the loop consumes it, never further ahead than one frame, so no
+// chunk is ever dropped to an overrun and the output doesn't depend on timing.
+//
+// Prints the number of spectra published and the strongest bin of every
+// channel in the last one. Each --expect fails the run unless that channel's
+// strongest bin lies within one bin width of HZ; overruns always fail it.
+
+#include "realtime_fft/pcm_file_source.h"
+#include "realtime_fft/realtime_fft.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace esphome::realtime_fft;
+
+// Hands the file to the capture task no faster than the component's loop takes
+// it in, so replays are lossless however slow the build
+class ThrottledSource : public AudioSource {
+ public:
+  ThrottledSource(AudioSource *source, size_t max_ahead) : source_(source), max_ahead_(max_ahead) {}
+
+  bool open(SampleFormat format, int sample_rate, int channels) override {
+    return this->source_->open(format, sample_rate, channels);
+  }
+  size_t read(uint8_t *dst, size_t max_bytes) override {
+    while (this->delivered_.load() - this->released_.load() + max_bytes > this->max_ahead_)
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    const size_t bytes = this->source_->read(dst, max_bytes);
+    if (bytes == 0)
+      this->finished_.store(true);
+    this->delivered_.fetch_add(bytes);
+    return bytes;
+  }
+  const char *name() const override { return this->source_->name(); }
+
+  size_t delivered() const { return this->delivered_.load(); }
+  // Everything delivered up to here has been consumed
+  void release(size_t bytes) { this->released_.store(bytes); }
+  bool finished() const { return this->finished_.load(); }
+
+ protected:
+  AudioSource *source_;
+  size_t max_ahead_;
+  std::atomic<size_t> delivered_{0};
+  std::atomic<size_t> released_{0};
+  std::atomic<bool> finished_{false};
+};
+
+static void usage() {
+  std::fprintf(stderr, "usage: pcm_replay [--fft-size N] [--hop-size N] [--channels N] [--first-channel N]\n"
+                       "                  [--precision float|q15|q31] [--expect CHANNEL:HZ]... file.wav\n");
+}
+
+int main(int argc, char **argv) {
+  int fft_size = 1024;
+  int hop_size = 0;
+  int channels = 1;
+  int first_channel = 0;
+  Precision precision = PRECISION_FLOAT;
+  std::vector<std::pair<int, float>> expected;
+  const char *path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--fft-size") == 0 && has_value) {
+      fft_size = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--hop-size") == 0 && has_value) {
+      hop_size = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--channels") == 0 && has_value) {
+      channels = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--first-channel") == 0 && has_value) {
+      first_channel = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--precision") == 0 && has_value) {
+      const char *name = argv[++i];
+      if (std::strcmp(name, "q15") == 0) {
+        precision = PRECISION_Q15;
+      } else if (std::strcmp(name, "q31") == 0) {
+        precision = PRECISION_Q31;
+      } else if (std::strcmp(name, "float") != 0) {
+        usage();
+        return 2;
+      }
+    } else if (std::strcmp(argv[i], "--expect") == 0 && has_value) {
+      int channel;
+      float frequency;
+      if (std::sscanf(argv[++i], "%d:%f", &channel, &frequency) != 2) {
+        usage();
+        return 2;
+      }
+      expected.emplace_back(channel, frequency);
+    } else if (argv[i][0] != '-' && path == nullptr) {
+      path = argv[i];
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (path == nullptr) {
+    usage();
+    return 2;
+  }
+
+  // Neither is ever destroyed: the capture task keeps polling the source until
+  // the process exits, as it would on the device
+  auto *file = new PcmFileSource(path);
+  if (!file->is_valid()) {
+    std::fprintf(stderr, "%s: %s\n", path, file->error());
+    return 1;
+  }
+  file->set_channel(first_channel);
+  const size_t sample_bytes = precision == PRECISION_Q15 ? sizeof(int16_t) : sizeof(float);
+  auto *source = new ThrottledSource(file, fft_size * channels * sample_bytes);
+
+  auto *component = new RealtimeFFTComponent();
+  component->set_sample_rate(file->file_sample_rate());
+  component->set_fft_size(fft_size);
+  component->set_hop_size(hop_size);
+  component->set_channels(channels);
+  component->set_precision(precision);
+  component->set_audio_source(source);
+  uint32_t published = 0;
+  component->add_on_state_callback([&published](float) { published++; });
+  component->setup();
+  if (component->is_failed()) {
+    std::fprintf(stderr, "%s: component setup failed\n", path);
+    return 1;
+  }
+
+  // Every loop() drains all the hops queued when it started, so once the
+  // source reports the end, one more iteration takes in the rest
+  bool last = false;
+  while (!last) {
+    last = source->finished();
+    const size_t delivered = source->delivered();
+    component->call_loop();
+    source->release(delivered);
+    if (!last)
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  int status = 0;
+  const float bin_width = (float) file->file_sample_rate() / fft_size;
+  // Frames reach publish_spectrum() one by one; the sensor only sees values that moved
+  const PipelineStats *stats = component->get_stats();
+  const uint32_t frames = stats != nullptr ? stats->stage(STAGE_PUBLISH).count() : published;
+  std::printf("%s: %zu sample frames at %d Hz, %u spectra, %u sensor values, %u overruns\n", path, file->frames(),
+              file->file_sample_rate(), frames, published, component->get_overruns());
+  if (frames == 0 || component->get_overruns() != 0)
+    status = 1;
+  for (int channel = 0; channel < component->get_channel_count() && frames > 0; channel++) {
+    const SpectrumView spectrum = component->get_channel_spectrum(channel);
+    size_t peak = 1;
+    for (size_t bin = 1; bin < spectrum.size(); bin++) {
+      if (spectrum[bin] > spectrum[peak])
+        peak = bin;
+    }
+    const float frequency = component->get_frequency(peak);
+    std::printf("channel %d: strongest bin %zu, %.1f Hz\n", channel, peak, frequency);
+    for (const auto &expect : expected) {
+      if (expect.first == channel && std::fabs(frequency - expect.second) > bin_width) {
+        std::fprintf(stderr, "channel %d: expected %.1f Hz\n", channel, expect.second);
+        status = 1;
+      }
+    }
+  }
+  for (const auto &expect : expected) {
+    if (expect.first >= component->get_channel_count()) {
+      std::fprintf(stderr, "channel %d: not analysed\n", expect.first);
+      status = 1;
+    }
+  }
+  return status;
+}
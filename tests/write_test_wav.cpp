@@ -0,0 +1,56 @@
+// Writes the recording the replay tests feed through pcm_replay: one second of
+// 16-bit stereo at 16 kHz, a 1000 Hz tone on the left channel and 2500 Hz on
+// the right, both exactly on a bin of a 1024-point FFT.
+//
+//   write_test_wav two_tones.wav
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+static void put16(FILE *f, uint16_t v) {
+  const uint8_t b[2] = {static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8)};
+  std::fwrite(b, 1, sizeof(b), f);
+}
+
+static void put32(FILE *f, uint32_t v) {
+  put16(f, static_cast<uint16_t>(v));
+  put16(f, static_cast<uint16_t>(v >> 16));
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: write_test_wav file.wav\n");
+    return 2;
+  }
+  const uint32_t sample_rate = 16000;
+  const uint16_t channels = 2;
+  const uint32_t frames = sample_rate;
+  const float frequencies[channels] = {1000.0f, 2500.0f};
+
+  FILE *f = std::fopen(argv[1], "wb");
+  if (f == nullptr) {
+    std::perror(argv[1]);
+    return 1;
+  }
+  const uint32_t data_bytes = frames * channels * sizeof(int16_t);
+  std::fwrite("RIFF", 1, 4, f);
+  put32(f, 36 + data_bytes);
+  std::fwrite("WAVEfmt ", 1, 8, f);
+  put32(f, 16);
+  put16(f, 1);
+  put16(f, channels);
+  put32(f, sample_rate);
+  put32(f, sample_rate * channels * sizeof(int16_t));
+  put16(f, channels * sizeof(int16_t));
+  put16(f, 16);
+  std::fwrite("data", 1, 4, f);
+  put32(f, data_bytes);
+  for (uint32_t i = 0; i < frames; i++) {
+    for (uint16_t c = 0; c < channels; c++) {
+      const double v = 0.5 * std::sin(2.0 * M_PI * frequencies[c] * i / sample_rate);
+      put16(f, static_cast<uint16_t>(static_cast<int16_t>(std::lround(v * 32767.0))));
+    }
+  }
+  return std::fclose(f) == 0 ? 0 : 1;
+}